@@ -0,0 +1,224 @@
+/* Copyright (c) 2025-2026 hors<horsicq@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "xbatchreader.h"
+
+#include <algorithm>
+
+namespace {
+const qint64 N_MAP_SPAN_LIMIT = 0x40000000;  // Larger spans are read run by run
+
+struct XBatchReaderOffsetLess {
+    const QVector<qint64> *pVecOffsets;
+
+    bool operator()(qint32 nLeft, qint32 nRight) const
+    {
+        return pVecOffsets->at(nLeft) < pVecOffsets->at(nRight);
+    }
+};
+}  // namespace
+
+XBatchReader::XBatchReader()
+{
+    m_pMappedFile = nullptr;
+    m_pMapped = nullptr;
+    m_nMappedSize = 0;
+}
+
+XBatchReader::~XBatchReader()
+{
+    _unmap();
+}
+
+qint32 XBatchReader::addRead(qint64 nOffset, qint64 nSize)
+{
+    READ read = {};
+    read.nOffset = nOffset;
+    read.nSize = qMax(nSize, (qint64)0);
+    read.nRun = -1;
+
+    m_vecReads.append(read);
+
+    return m_vecReads.count() - 1;
+}
+
+qint32 XBatchReader::getNumberOfReads() const
+{
+    return m_vecReads.count();
+}
+
+qint32 XBatchReader::getNumberOfRuns() const
+{
+    return m_vecRuns.count();
+}
+
+void XBatchReader::clear()
+{
+    _unmap();
+    m_vecReads.clear();
+    m_vecRuns.clear();
+}
+
+bool XBatchReader::execute(QIODevice *pDevice, qint64 nMaxGap, qint64 nMaxRunSize)
+{
+    _unmap();
+    m_vecRuns.clear();
+
+    qint32 nNumberOfReads = m_vecReads.count();
+
+    if ((!pDevice) || pDevice->isSequential() || (nNumberOfReads == 0)) {
+        return false;
+    }
+
+    qint64 nDeviceSize = pDevice->size();
+    QVector<qint64> vecOffsets(nNumberOfReads);
+    QVector<qint32> vecOrder(nNumberOfReads);
+
+    for (qint32 i = 0; i < nNumberOfReads; i++) {
+        vecOffsets[i] = m_vecReads.at(i).nOffset;
+        vecOrder[i] = i;
+    }
+
+    XBatchReaderOffsetLess offsetLess;
+    offsetLess.pVecOffsets = &vecOffsets;
+    std::sort(vecOrder.begin(), vecOrder.end(), offsetLess);
+
+    // Runs: ranges sorted by offset, merged while they overlap or lie at most nMaxGap apart
+    QVector<QPair<qint64, qint64>> vecRunRanges;
+
+    for (qint32 i = 0; i < nNumberOfReads; i++) {
+        READ &read = m_vecReads[vecOrder.at(i)];
+
+        if ((read.nOffset < 0) || (read.nOffset >= nDeviceSize)) {
+            continue;
+        }
+
+        qint64 nEnd = qMin(read.nOffset + read.nSize, nDeviceSize);
+
+        if (!vecRunRanges.isEmpty()) {
+            QPair<qint64, qint64> &runRange = vecRunRanges.last();
+
+            if ((read.nOffset <= (runRange.second + nMaxGap)) && ((qMax(nEnd, runRange.second) - runRange.first) <= nMaxRunSize)) {
+                runRange.second = qMax(nEnd, runRange.second);
+                read.nRun = vecRunRanges.count() - 1;
+                read.nRunOffset = read.nOffset - runRange.first;
+                continue;
+            }
+        }
+
+        vecRunRanges.append(qMakePair(read.nOffset, nEnd));
+        read.nRun = vecRunRanges.count() - 1;
+        read.nRunOffset = 0;
+    }
+
+    qint32 nNumberOfRuns = vecRunRanges.count();
+
+    if (nNumberOfRuns == 0) {
+        return false;
+    }
+
+    // Many runs of a file: one mapping of the whole span, no copies
+    QFile *pFile = qobject_cast<QFile *>(pDevice);
+    qint64 nSpanStart = vecRunRanges.first().first;
+    qint64 nSpanSize = vecRunRanges.last().second - nSpanStart;
+
+    if (pFile && (nNumberOfRuns > 1) && (nSpanSize <= N_MAP_SPAN_LIMIT)) {
+        m_pMapped = pFile->map(nSpanStart, nSpanSize);
+
+        if (m_pMapped) {
+            m_pMappedFile = pFile;
+            m_nMappedSize = nSpanSize;
+
+            for (qint32 i = 0; i < nNumberOfReads; i++) {
+                READ &read = m_vecReads[i];
+
+                if (read.nRun != -1) {
+                    read.nRunOffset = read.nOffset - nSpanStart;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    qint64 nPrevPos = pDevice->pos();
+    m_vecRuns.resize(nNumberOfRuns);
+
+    for (qint32 i = 0; i < nNumberOfRuns; i++) {
+        RUN &run = m_vecRuns[i];
+        run.nOffset = vecRunRanges.at(i).first;
+
+        if (pDevice->seek(run.nOffset)) {
+            run.baData = pDevice->read(vecRunRanges.at(i).second - run.nOffset);
+        }
+    }
+
+    pDevice->seek(nPrevPos);
+
+    return true;
+}
+
+const char *XBatchReader::getData(qint32 nIndex, qint64 *pnSize) const
+{
+    const char *pResult = nullptr;
+    *pnSize = 0;
+
+    if ((nIndex >= 0) && (nIndex < m_vecReads.count())) {
+        const READ &read = m_vecReads.at(nIndex);
+
+        if (read.nRun != -1) {
+            const char *pData = nullptr;
+            qint64 nDataSize = 0;
+
+            if (m_pMapped) {
+                pData = (const char *)m_pMapped;
+                nDataSize = m_nMappedSize;
+            } else if (read.nRun < m_vecRuns.count()) {
+                pData = m_vecRuns.at(read.nRun).baData.constData();
+                nDataSize = m_vecRuns.at(read.nRun).baData.size();
+            }
+
+            if (pData && (read.nRunOffset < nDataSize)) {
+                pResult = pData + read.nRunOffset;
+                *pnSize = qMin(read.nSize, nDataSize - read.nRunOffset);
+            }
+        }
+    }
+
+    return pResult;
+}
+
+QByteArray XBatchReader::getArray(qint32 nIndex) const
+{
+    qint64 nSize = 0;
+    const char *pData = getData(nIndex, &nSize);
+
+    return pData ? QByteArray(pData, (qint32)nSize) : QByteArray();
+}
+
+void XBatchReader::_unmap()
+{
+    if (m_pMapped) {
+        m_pMappedFile->unmap(m_pMapped);
+        m_pMapped = nullptr;
+        m_pMappedFile = nullptr;
+        m_nMappedSize = 0;
+    }
+}
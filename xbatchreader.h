@@ -0,0 +1,67 @@
+/* Copyright (c) 2025-2026 hors<horsicq@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef XBATCHREADER_H
+#define XBATCHREADER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QVector>
+
+// Gathers many small (offset, size) reads of one device and executes them in file offset order:
+// overlapping and nearby ranges are merged into runs, every run is one seek and one read.
+// A QFile is mapped once instead. Not thread-safe; the caller serializes access to the device.
+class XBatchReader {
+public:
+    XBatchReader();
+    ~XBatchReader();
+
+    qint32 addRead(qint64 nOffset, qint64 nSize);  // Returns the index for getData()
+    qint32 getNumberOfReads() const;
+    qint32 getNumberOfRuns() const;
+    void clear();
+    bool execute(QIODevice *pDevice, qint64 nMaxGap = 0x1000, qint64 nMaxRunSize = 0x100000);
+    const char *getData(qint32 nIndex, qint64 *pnSize) const;  // nullptr if nothing was read; *pnSize is short at the end of the device
+    QByteArray getArray(qint32 nIndex) const;
+
+private:
+    void _unmap();
+
+    struct READ {
+        qint64 nOffset;
+        qint64 nSize;
+        qint32 nRun;         // -1: not read
+        qint64 nRunOffset;   // Position in the run, or in the mapping
+    };
+
+    struct RUN {
+        qint64 nOffset;
+        QByteArray baData;
+    };
+
+    QVector<READ> m_vecReads;
+    QVector<RUN> m_vecRuns;
+    QFile *m_pMappedFile;
+    uchar *m_pMapped;
+    qint64 m_nMappedSize;
+};
+
+#endif  // XBATCHREADER_H
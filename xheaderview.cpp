@@ -19,10 +19,22 @@
  * SOFTWARE.
  */
 #include "xheaderview.h"
+
+#include <QApplication>
+#include <QMouseEvent>
+#include <QPainter>
 #include <QSignalBlocker>
+#include <QStyleOptionFrame>
+
+namespace {
+const qint32 N_LINEEDIT_POOL_LIMIT = 2;
+}  // namespace
 
 XHeaderView::XHeaderView(QWidget *pParent) : QHeaderView(Qt::Horizontal, pParent)
 {
+    m_pLineEdit = nullptr;
+    m_nActiveFilter = -1;
+    m_nFilterHeight = 0;
     m_nPressedSortIndicatorSection = -1;
     m_pressedSortIndicatorOrder = Qt::AscendingOrder;
 
@@ -35,21 +47,24 @@ XHeaderView::XHeaderView(QWidget *pParent) : QHeaderView(Qt::Horizontal, pParent
 
 XHeaderView::~XHeaderView()
 {
-    qint32 nCount = m_listLineEdits.count();
+    delete m_pLineEdit;
+    m_pLineEdit = nullptr;
+
+    qint32 nCount = m_listLineEditPool.count();
 
     for (qint32 i = 0; i < nCount; i++) {
-        delete m_listLineEdits.at(i);
+        delete m_listLineEditPool.at(i);
     }
 
-    m_listLineEdits.clear();
+    m_listLineEditPool.clear();
 }
 
 QSize XHeaderView::sizeHint() const
 {
     QSize baseSize = QHeaderView::sizeHint();
 
-    if (m_listLineEdits.count()) {
-        baseSize.setHeight(baseSize.height() + 4 + m_listLineEdits.at(0)->sizeHint().height());
+    if (m_vecFilters.count()) {
+        baseSize.setHeight(baseSize.height() + 4 + m_nFilterHeight);
     }
 
     return baseSize;
@@ -57,16 +72,14 @@ QSize XHeaderView::sizeHint() const
 
 void XHeaderView::setNumberOfFilters(qint32 nNumberOfFilters)
 {
-    qint32 nOldCount = m_listLineEdits.count();
-
-    for (qint32 i = 0; i < nOldCount; i++) {
-        delete m_listLineEdits.at(i);
+    if (m_pLineEdit) {
+        _deactivateFilter();
     }
 
-    m_listLineEdits.clear();
+    m_vecFilters.clear();
+    m_vecFilters.reserve(nNumberOfFilters);
 
     for (qint32 i = 0; i < nNumberOfFilters; i++) {
-        QLineEdit *pLineEdit = new QLineEdit(this);
         QString sColumnName;
 
         if (model()) {
@@ -77,33 +90,43 @@ void XHeaderView::setNumberOfFilters(qint32 nNumberOfFilters)
             sColumnName = tr("column %1").arg(i + 1);
         }
 
-        QString sFilterPrompt = tr("Filter %1").arg(sColumnName);
-        pLineEdit->setObjectName(QStringLiteral("columnFilter"));
-        pLineEdit->setPlaceholderText(sFilterPrompt);
-        pLineEdit->setToolTip(sFilterPrompt);
-        pLineEdit->setAccessibleName(sFilterPrompt);
-        pLineEdit->setClearButtonEnabled(true);
-        connect(pLineEdit, SIGNAL(textChanged(QString)), this, SLOT(_textChanged(QString)));
-        m_listLineEdits.append(pLineEdit);
+        FILTER filter;
+        filter.sPrompt = tr("Filter %1").arg(sColumnName);
+        filter.bEnabled = true;
+
+        m_vecFilters.append(filter);
     }
 
+    _updateFilterHeight();
     adjustPositions();
 }
 
 void XHeaderView::clearFilters()
 {
-    qint32 nCount = m_listLineEdits.count();
+    if (m_pLineEdit) {
+        m_pLineEdit->clear();  // Emits filterChanged() through _textChanged()
+    }
+
+    bool bChanged = false;
+    qint32 nCount = m_vecFilters.count();
 
     for (qint32 i = 0; i < nCount; i++) {
-        m_listLineEdits.at(i)->clear();
+        if (!m_vecFilters.at(i).sText.isEmpty()) {
+            m_vecFilters[i].sText.clear();
+            bChanged = true;
+        }
+    }
+
+    if (bChanged) {
+        update(_getFilterRowRect());
+        emit filterChanged();
     }
 }
 
 void XHeaderView::updateGeometries()
 {
-    if (m_listLineEdits.count()) {
-        qint32 nLineEditHeight = m_listLineEdits.at(0)->sizeHint().height();
-        setViewportMargins(0, 0, 0, nLineEditHeight + 4);
+    if (m_vecFilters.count()) {
+        setViewportMargins(0, 0, 0, m_nFilterHeight + 4);
     } else {
         setViewportMargins(0, 0, 0, 0);
     }
@@ -114,27 +137,29 @@ void XHeaderView::updateGeometries()
 
 void XHeaderView::adjustPositions()
 {
-    qint32 nCount = m_listLineEdits.count();
-
-    QSize baseSize = QHeaderView::sizeHint();
-
-    for (qint32 i = 0; i < nCount; i++) {
-        qint32 nLineEditHeight = m_listLineEdits.at(i)->sizeHint().height();
-
-        m_listLineEdits.at(i)->move(sectionPosition(i) - offset(), baseSize.height() + 2);
-        m_listLineEdits.at(i)->resize(sectionSize(i) - 2, nLineEditHeight);
-        m_listLineEdits.at(i)->show();
+    // Only the active editor is a widget; the other filters follow with the next paint
+    if (m_pLineEdit) {
+        QRect rectFilter = _getFilterRect(m_nActiveFilter);
+
+        if (rectFilter.isValid() && (rectFilter.right() >= 0) && (rectFilter.left() < viewport()->width())) {
+            m_pLineEdit->setGeometry(rectFilter);
+            m_pLineEdit->show();
+        } else {
+            m_pLineEdit->hide();  // Scrolled out: keeps the focus and the text until editing finishes
+        }
     }
+
+    update(_getFilterRowRect());
 }
 
 QList<QString> XHeaderView::getFilters()
 {
     QList<QString> listResult;
 
-    qint32 nCount = m_listLineEdits.count();
+    qint32 nCount = m_vecFilters.count();
 
     for (qint32 i = 0; i < nCount; i++) {
-        listResult.append(m_listLineEdits.at(i)->text());
+        listResult.append(m_vecFilters.at(i).sText);
     }
 
     return listResult;
@@ -142,24 +167,247 @@ QList<QString> XHeaderView::getFilters()
 
 void XHeaderView::setFilterText(qint32 nColumn, const QString &sText)
 {
-    if ((nColumn >= 0) && (nColumn < m_listLineEdits.count())) {
-        m_listLineEdits.at(nColumn)->setText(sText);
+    if ((nColumn >= 0) && (nColumn < m_vecFilters.count())) {
+        if (nColumn == m_nActiveFilter) {
+            m_pLineEdit->setText(sText);
+        } else if (m_vecFilters.at(nColumn).sText != sText) {
+            m_vecFilters[nColumn].sText = sText;
+            update(_getFilterRect(nColumn));
+            emit filterChanged();
+        }
     }
 }
 
 void XHeaderView::setFilterEnabled(qint32 nColumn, bool bFilterEnabled)
 {
     // TODO
-    if ((nColumn >= 0) && (nColumn < m_listLineEdits.count())) {
-        m_listLineEdits.at(nColumn)->setReadOnly(!bFilterEnabled);
+    if ((nColumn >= 0) && (nColumn < m_vecFilters.count())) {
+        m_vecFilters[nColumn].bEnabled = bFilterEnabled;
+
+        if (nColumn == m_nActiveFilter) {
+            m_pLineEdit->setReadOnly(!bFilterEnabled);
+        }
+
+        update(_getFilterRect(nColumn));
+    }
+}
+
+bool XHeaderView::event(QEvent *pEvent)
+{
+    bool bResult = QHeaderView::event(pEvent);
+
+    // The filter row lies in the bottom viewport margin: paint and clicks arrive at the header widget itself
+    if (pEvent->type() == QEvent::Paint) {
+        if (m_vecFilters.count()) {
+            _paintFilters(static_cast<QPaintEvent *>(pEvent)->rect());
+        }
+    } else if (pEvent->type() == QEvent::MouseButtonPress) {
+        QMouseEvent *pMouseEvent = static_cast<QMouseEvent *>(pEvent);
+        qint32 nColumn = _getFilterAt(pMouseEvent->pos());
+
+        if ((nColumn != -1) && (pMouseEvent->button() == Qt::LeftButton)) {
+            _activateFilter(nColumn);
+            bResult = true;
+        }
+    } else if ((pEvent->type() == QEvent::FontChange) || (pEvent->type() == QEvent::StyleChange)) {
+        _updateFilterHeight();
     }
+
+    return bResult;
 }
 
 void XHeaderView::_textChanged(const QString &sText)
 {
-    Q_UNUSED(sText)
+    if ((sender() == m_pLineEdit) && (m_nActiveFilter != -1)) {
+        m_vecFilters[m_nActiveFilter].sText = sText;
+
+        emit filterChanged();
+    }
+}
+
+void XHeaderView::_editingFinished()
+{
+    if (m_pLineEdit && (sender() == m_pLineEdit)) {
+        _deactivateFilter();
+    }
+}
+
+QRect XHeaderView::_getFilterRect(qint32 nColumn) const
+{
+    QRect rectResult;
+
+    if ((nColumn >= 0) && (nColumn < m_vecFilters.count()) && (nColumn < count()) && !isSectionHidden(nColumn)) {
+        rectResult = QRect(sectionViewportPosition(nColumn), QHeaderView::sizeHint().height() + 2, sectionSize(nColumn) - 2, m_nFilterHeight);
+    }
+
+    return rectResult;
+}
+
+QRect XHeaderView::_getFilterRowRect() const
+{
+    return QRect(0, QHeaderView::sizeHint().height(), width(), m_nFilterHeight + 4);
+}
+
+qint32 XHeaderView::_getFilterAt(const QPoint &pos) const
+{
+    qint32 nResult = -1;
+
+    if (m_vecFilters.count() && _getFilterRowRect().contains(pos)) {
+        qint32 nColumn = logicalIndexAt(pos.x());
+
+        if (_getFilterRect(nColumn).contains(pos)) {
+            nResult = nColumn;
+        }
+    }
+
+    return nResult;
+}
+
+void XHeaderView::_paintFilters(const QRect &rectUpdate)
+{
+    qint32 nFirst = visualIndexAt(0);
+    qint32 nLast = visualIndexAt(viewport()->width() - 1);
+
+    if (nFirst == -1) {
+        nFirst = 0;
+    }
+
+    if (nLast == -1) {
+        nLast = count() - 1;
+    }
+
+    QPainter painter(this);
+    painter.setClipRect(rectUpdate);
+
+    QColor colorPrompt = palette().color(QPalette::Disabled, QPalette::Text);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    colorPrompt = palette().color(QPalette::PlaceholderText);
+#endif
+
+    for (qint32 i = nFirst; i <= nLast; i++) {
+        qint32 nColumn = logicalIndex(i);
+
+        if ((nColumn == m_nActiveFilter) && m_pLineEdit && m_pLineEdit->isVisible()) {
+            continue;
+        }
+
+        QRect rectFilter = _getFilterRect(nColumn);
+
+        if (!rectFilter.isValid() || !rectFilter.intersects(rectUpdate)) {
+            continue;
+        }
+
+        const FILTER &filter = m_vecFilters.at(nColumn);
+
+        QStyleOptionFrame option;
+        option.initFrom(this);
+        option.rect = rectFilter;
+        option.lineWidth = style()->pixelMetric(QStyle::PM_DefaultFrameWidth, &option, this);
+        option.midLineWidth = 0;
+        option.state |= QStyle::State_Sunken;
+
+        if (!filter.bEnabled) {
+            option.state |= QStyle::State_ReadOnly;
+        }
+
+        style()->drawPrimitive(QStyle::PE_PanelLineEdit, &option, &painter, this);
+
+        QRect rectText = style()->subElementRect(QStyle::SE_LineEditContents, &option, this).adjusted(2, 0, -2, 0);
+        QString sText = filter.sText;
+
+        if (sText.isEmpty()) {
+            sText = filter.sPrompt;
+            painter.setPen(colorPrompt);
+        } else {
+            painter.setPen(palette().color(QPalette::Text));
+        }
+
+        painter.drawText(rectText, Qt::AlignVCenter | Qt::AlignLeft, fontMetrics().elidedText(sText, Qt::ElideRight, rectText.width()));
+    }
+}
+
+void XHeaderView::_updateFilterHeight()
+{
+    QLineEdit *pLineEdit = m_pLineEdit ? m_pLineEdit : _takeLineEdit();
+
+    m_nFilterHeight = pLineEdit->sizeHint().height();
+
+    if (pLineEdit != m_pLineEdit) {
+        _releaseLineEdit(pLineEdit);
+    }
+}
+
+void XHeaderView::_activateFilter(qint32 nColumn)
+{
+    if (nColumn == m_nActiveFilter) {
+        return;
+    }
+
+    if (m_pLineEdit) {
+        _deactivateFilter();
+    }
+
+    const FILTER &filter = m_vecFilters.at(nColumn);
+
+    m_pLineEdit = _takeLineEdit();
+    m_nActiveFilter = nColumn;
+
+    {
+        QSignalBlocker blocker(m_pLineEdit);
+        m_pLineEdit->setText(filter.sText);
+    }
+
+    m_pLineEdit->setPlaceholderText(filter.sPrompt);
+    m_pLineEdit->setToolTip(filter.sPrompt);
+    m_pLineEdit->setAccessibleName(filter.sPrompt);
+    m_pLineEdit->setReadOnly(!filter.bEnabled);
+
+    adjustPositions();
+
+    m_pLineEdit->setFocus(Qt::MouseFocusReason);
+}
+
+void XHeaderView::_deactivateFilter()
+{
+    QLineEdit *pLineEdit = m_pLineEdit;
+    qint32 nColumn = m_nActiveFilter;
+
+    // Cleared first: hiding the editor moves the focus and emits editingFinished() again
+    m_pLineEdit = nullptr;
+    m_nActiveFilter = -1;
+
+    _releaseLineEdit(pLineEdit);
+
+    update(_getFilterRect(nColumn));
+}
+
+QLineEdit *XHeaderView::_takeLineEdit()
+{
+    QLineEdit *pResult = nullptr;
+
+    if (m_listLineEditPool.count()) {
+        pResult = m_listLineEditPool.takeLast();
+    } else {
+        pResult = new QLineEdit(this);
+        pResult->setObjectName(QStringLiteral("columnFilter"));
+        pResult->setClearButtonEnabled(true);
+        pResult->hide();
+        connect(pResult, SIGNAL(textChanged(QString)), this, SLOT(_textChanged(QString)));
+        connect(pResult, SIGNAL(editingFinished()), this, SLOT(_editingFinished()));
+    }
+
+    return pResult;
+}
+
+void XHeaderView::_releaseLineEdit(QLineEdit *pLineEdit)
+{
+    pLineEdit->hide();
 
-    emit filterChanged();
+    if (m_listLineEditPool.count() < N_LINEEDIT_POOL_LIMIT) {
+        m_listLineEditPool.append(pLineEdit);
+    } else {
+        pLineEdit->deleteLater();
+    }
 }
 
 void XHeaderView::onSectionResized(int i, int nOldSize, int nNewSize)
@@ -189,10 +437,97 @@ void XHeaderView::onSectionClicked(int logicalIndex)
         sortOrder = Qt::AscendingOrder;
     }
 
+    bool bMultiSort = (QApplication::keyboardModifiers() & Qt::ShiftModifier) && (m_nPressedSortIndicatorSection >= 0);
+
+    if (bMultiSort) {
+        if (m_listSortColumns.isEmpty() || (m_listSortColumns.at(0).nColumn != m_nPressedSortIndicatorSection)) {
+            XModel::SORT_COLUMN sortColumn = {m_nPressedSortIndicatorSection, m_pressedSortIndicatorOrder};
+            m_listSortColumns.clear();
+            m_listSortColumns.append(sortColumn);
+        }
+
+        bool bFound = false;
+
+        for (qint32 i = 0; i < m_listSortColumns.count(); i++) {
+            if (m_listSortColumns.at(i).nColumn == logicalIndex) {
+                m_listSortColumns[i].order = (m_listSortColumns.at(i).order == Qt::AscendingOrder) ? Qt::DescendingOrder : Qt::AscendingOrder;
+                bFound = true;
+                break;
+            }
+        }
+
+        if (!bFound) {
+            XModel::SORT_COLUMN sortColumn = {logicalIndex, Qt::AscendingOrder};
+            m_listSortColumns.append(sortColumn);
+        }
+
+        {
+            // The indicator stays on the primary key
+            QSignalBlocker blocker(this);
+            setSortIndicator(m_listSortColumns.at(0).nColumn, m_listSortColumns.at(0).order);
+        }
+
+        viewport()->update();
+
+        emit multiSortRequested(m_listSortColumns);
+    } else {
+        XModel::SORT_COLUMN sortColumn = {logicalIndex, sortOrder};
+        m_listSortColumns.clear();
+        m_listSortColumns.append(sortColumn);
+
+        {
+            QSignalBlocker blocker(this);
+            setSortIndicator(logicalIndex, sortOrder);
+        }
+
+        viewport()->update();
+
+        emit sortRequested(logicalIndex, sortOrder);
+    }
+}
+
+void XHeaderView::setSortColumns(const QList<XModel::SORT_COLUMN> &listColumns)
+{
+    m_listSortColumns = listColumns;
+
     {
         QSignalBlocker blocker(this);
-        setSortIndicator(logicalIndex, sortOrder);
+
+        if (listColumns.isEmpty()) {
+            setSortIndicator(-1, Qt::AscendingOrder);
+        } else {
+            setSortIndicator(listColumns.at(0).nColumn, listColumns.at(0).order);
+        }
     }
 
-    emit sortRequested(logicalIndex, sortOrder);
+    viewport()->update();
+}
+
+QList<XModel::SORT_COLUMN> XHeaderView::getSortColumns() const
+{
+    return m_listSortColumns;
+}
+
+void XHeaderView::paintSection(QPainter *pPainter, const QRect &rect, int nLogicalIndex) const
+{
+    QHeaderView::paintSection(pPainter, rect, nLogicalIndex);
+
+    // Secondary keys: their position and order in the top right corner
+    for (qint32 i = 1; i < m_listSortColumns.count(); i++) {
+        if (m_listSortColumns.at(i).nColumn == nLogicalIndex) {
+            QString sText = QString("%1%2").arg(i + 1).arg((m_listSortColumns.at(i).order == Qt::AscendingOrder) ? QChar(0x25B2) : QChar(0x25BC));
+
+            pPainter->save();
+            QFont font = pPainter->font();
+            if (font.pointSizeF() > 0) {
+                font.setPointSizeF(font.pointSizeF() * 0.75);
+            }
+            pPainter->setFont(font);
+            pPainter->setPen(palette().color(QPalette::Mid));
+            pPainter->drawText(rect.adjusted(2, 1, -3, 0), Qt::AlignTop | Qt::AlignRight, sText);
+            pPainter->restore();
+
+            break;
+        }
+    }
 }
@@ -24,7 +24,11 @@
 #include <QHeaderView>
 #include <QLineEdit>
 #include <QObject>
+#include "xmodel.h"
 
+// The filter row is painted as text; a real QLineEdit, recycled from a small pool, exists only for the
+// filter being edited. Only the sections inside the viewport are painted and laid out.
+// Shift+click adds a column to the sort keys (or flips its order); the secondary keys show their position.
 class XHeaderView : public QHeaderView {
     Q_OBJECT
 
@@ -40,9 +44,16 @@ public:
     QList<QString> getFilters();
     void setFilterText(qint32 nColumn, const QString &sText);
     void setFilterEnabled(qint32 nColumn, bool bFilterEnabled);
+    void setSortColumns(const QList<XModel::SORT_COLUMN> &listColumns);  // Without signals
+    QList<XModel::SORT_COLUMN> getSortColumns() const;
+
+protected:
+    bool event(QEvent *pEvent) override;
+    void paintSection(QPainter *pPainter, const QRect &rect, int nLogicalIndex) const override;
 
 private slots:
     void _textChanged(const QString &sText);
+    void _editingFinished();
     void onSectionResized(int i, int nOldSize, int nNewSize);
     void onSectionPressed(int logicalIndex);
     void onSectionClicked(int logicalIndex);
@@ -50,11 +61,33 @@ private slots:
 signals:
     void filterChanged();
     void sortRequested(int nColumn, Qt::SortOrder order);
+    void multiSortRequested(const QList<XModel::SORT_COLUMN> &listColumns);
 
 private:
-    QList<QLineEdit *> m_listLineEdits;
+    struct FILTER {
+        QString sText;
+        QString sPrompt;
+        bool bEnabled;
+    };
+
+    QRect _getFilterRect(qint32 nColumn) const;
+    QRect _getFilterRowRect() const;
+    qint32 _getFilterAt(const QPoint &pos) const;
+    void _paintFilters(const QRect &rectUpdate);
+    void _updateFilterHeight();
+    void _activateFilter(qint32 nColumn);
+    void _deactivateFilter();
+    QLineEdit *_takeLineEdit();
+    void _releaseLineEdit(QLineEdit *pLineEdit);
+
+    QVector<FILTER> m_vecFilters;
+    QList<QLineEdit *> m_listLineEditPool;  // Hidden editors ready for reuse
+    QLineEdit *m_pLineEdit;                 // Editor of m_nActiveFilter
+    qint32 m_nActiveFilter;                 // -1: all filters are painted
+    qint32 m_nFilterHeight;
     qint32 m_nPressedSortIndicatorSection;
     Qt::SortOrder m_pressedSortIndicatorOrder;
+    QList<XModel::SORT_COLUMN> m_listSortColumns;  // Primary key first; the sort indicator shows the primary key
 };
 
 #endif  // XHEADERVIEW_H
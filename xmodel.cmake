@@ -1,7 +1,18 @@
 include_directories(${CMAKE_CURRENT_LIST_DIR})
 
+# Sorting, the value cache and the lazy fetch run on QtConcurrent
+find_package(QT NAMES Qt6 Qt5 REQUIRED COMPONENTS Concurrent)
+find_package(Qt${QT_VERSION_MAJOR} REQUIRED COMPONENTS Concurrent)
+
+set(XMODEL_LIBS
+    ${XMODEL_LIBS}
+    Qt${QT_VERSION_MAJOR}::Concurrent
+)
+
 set(XMODEL_SOURCES
     ${XMODEL_SOURCES}
     ${CMAKE_CURRENT_LIST_DIR}/xmodel.cpp
     ${CMAKE_CURRENT_LIST_DIR}/xmodel.h
+    ${CMAKE_CURRENT_LIST_DIR}/xbatchreader.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/xbatchreader.h
 )
@@ -21,12 +21,25 @@
 
 #include "xmodel.h"
 
+#include <algorithm>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QThread>
 #include <QXmlStreamWriter>
+#include <QtConcurrent>
 
 namespace {
+// Same order as the proxy's variantLessThan() for two strings
+struct XModelTextLess {
+    const QVector<QString> *pVecTexts;
+
+    bool operator()(qint32 nLeft, qint32 nRight) const
+    {
+        return pVecTexts->at(nLeft) < pVecTexts->at(nRight);
+    }
+};
+
 QString getHeaderName(const QAbstractItemModel *pModel, qint32 nColumn)
 {
     QString sResult = pModel->headerData(nColumn, Qt::Horizontal, Qt::DisplayRole).toString().trimmed();
@@ -65,16 +78,141 @@ QString headerToXmlTagName(const QString &sHeader, qint32 nColumn)
 
     return sResult;
 }
+
+const quint64 N_DISPLAY_CACHE_EMPTY = (quint64)-1;
+
+// Registry of the living models for the memory budget; the models are used from the GUI thread only
+QList<XModel *> g_listMemoryModels;
+qint64 g_nMemoryBudget = 0;
+quint64 g_nViewCounter = 0;
+
+const qint32 N_RADIX_PARALLEL_THRESHOLD = 0x100000;  // Rows from which the radix passes are split across the thread pool
+const qint32 N_PARTIAL_SORT_THRESHOLD = 0x40000;     // Smaller models are sorted completely in a few ms
+
+// One chunk of a radix pass: counts the digits of the chunk, or scatters it to the offsets reserved for it
+struct XModelRadixChunk {
+    typedef void result_type;
+
+    const quint64 *pKeys;
+    const qint32 *pIndex;
+    quint64 *pKeysOut;
+    qint32 *pIndexOut;
+    qint64 *pCounts;  // 256 per chunk: the digit histogram, then the scatter positions
+    qint32 nShift;
+    qint32 nChunkSize;
+    qint32 nCount;
+    bool bScatter;
+
+    void operator()(const qint32 &nChunk) const
+    {
+        qint32 nBegin = nChunk * nChunkSize;
+        qint32 nEnd = qMin(nBegin + nChunkSize, nCount);
+        qint64 *pChunkCounts = pCounts + nChunk * 256;
+
+        if (!bScatter) {
+            for (qint32 i = nBegin; i < nEnd; i++) {
+                pChunkCounts[(pKeys[i] >> nShift) & 0xFF]++;
+            }
+        } else {
+            for (qint32 i = nBegin; i < nEnd; i++) {
+                qint64 nPos = pChunkCounts[(pKeys[i] >> nShift) & 0xFF]++;
+                pKeysOut[nPos] = pKeys[i];
+                pIndexOut[nPos] = pIndex[i];
+            }
+        }
+    }
+};
+
+bool _compareLastViewed(const QPair<quint64, XModel *> &a, const QPair<quint64, XModel *> &b)
+{
+    return a.first < b.first;
+}
+
+// Column width estimation: small models are measured completely, big ones through a sample of rows.
+// With N_ADJUST_STRIDED_ROWS independent strided samples, the rule of three bounds the rows wider than
+// the sampled maximum to 3 / 0x800 (< 0.15%) with 95% confidence; those are elided by the view.
+const qint32 N_ADJUST_FULL_LIMIT = 0x2000;
+const qint32 N_ADJUST_EDGE_ROWS = 0x100;
+const qint32 N_ADJUST_VISIBLE_ROWS = 0x200;
+const qint32 N_ADJUST_STRIDED_ROWS = 0x800;
+
+// First, last and visible rows, then one jittered row per stride
+QVector<qint32> _getAdjustSampleRows(qint32 nNumberOfRows, qint32 nColumn, qint32 nVisibleRow, qint32 nVisibleCount)
+{
+    QVector<qint32> vecResult;
+    vecResult.reserve(2 * N_ADJUST_EDGE_ROWS + N_ADJUST_VISIBLE_ROWS + N_ADJUST_STRIDED_ROWS);
+
+    for (qint32 i = 0; i < N_ADJUST_EDGE_ROWS; i++) {
+        vecResult.append(i);
+        vecResult.append(nNumberOfRows - 1 - i);
+    }
+
+    if (nVisibleRow >= 0) {
+        qint32 nEnd = qMin(nNumberOfRows, nVisibleRow + qMin(nVisibleCount, N_ADJUST_VISIBLE_ROWS));
+
+        for (qint32 i = nVisibleRow; i < nEnd; i++) {
+            vecResult.append(i);
+        }
+    }
+
+    qint32 nStride = nNumberOfRows / N_ADJUST_STRIDED_ROWS;
+    quint32 nRandom = (quint32)nNumberOfRows ^ ((quint32)nColumn * 0x9E3779B9u) ^ 0x2545F491u;
+
+    for (qint32 i = 0; i < N_ADJUST_STRIDED_ROWS; i++) {
+        // xorshift32: deterministic, so the same model gets the same widths
+        nRandom ^= nRandom << 13;
+        nRandom ^= nRandom >> 17;
+        nRandom ^= nRandom << 5;
+
+        vecResult.append(i * nStride + (qint32)(nRandom % (quint32)nStride));
+    }
+
+    return vecResult;
+}
 }  // namespace
 
 XModel::XModel(QObject *pParent) : QAbstractItemModel(pParent)
 {
     m_nRowCount = 0;
     m_nColumnCount = 0;
+    m_bDisplayCacheEnabled = false;
+    m_nDisplayCacheBudget = 0;
+    m_nDisplayCacheSize = 0;
+    m_nLastViewed = 0;
+    m_bBusy = false;
+    m_bMemoryRegistered = true;
+    m_bPartialSortEnabled = false;
+    m_nPartialSortRows = 0;
+    m_bPartialSortPending = false;
+    m_pPartialSortWatcher = nullptr;
+
+    g_listMemoryModels.append(this);
+
+    connect(this, &QAbstractItemModel::dataChanged, this, &XModel::_invalidateDisplayCache);
+    connect(this, &QAbstractItemModel::layoutChanged, this, &XModel::clearDisplayCache);
+    connect(this, &QAbstractItemModel::modelReset, this, &XModel::clearDisplayCache);
 }
 
 XModel::~XModel()
 {
+    if (m_bMemoryRegistered) {
+        g_listMemoryModels.removeOne(this);
+    }
+}
+
+void XModel::prepareForDeferredDelete()
+{
+    if (m_bMemoryRegistered) {
+        g_listMemoryModels.removeOne(this);
+        m_bMemoryRegistered = false;
+    }
+
+    if (m_pPartialSortWatcher) {
+        // The finished notification would otherwise be delivered on the deleting thread
+        _cancelPartialSort();
+        disconnect(m_pPartialSortWatcher, nullptr, this, nullptr);
+        m_pPartialSortWatcher->waitForFinished();
+    }
 }
 
 void XModel::setColumnSymbolSize(qint32 nColumn, qint32 nValue)
@@ -107,6 +245,16 @@ QString XModel::getColumnName(qint32 nColumn) const
     return m_hashColumnName.value(nColumn, "");
 }
 
+void XModel::setColumnSortKey(qint32 nColumn, SORT_KEY sortKey)
+{
+    m_hashColumnSortKey[nColumn] = sortKey;
+}
+
+XModel::SORT_KEY XModel::getColumnSortKey(qint32 nColumn) const
+{
+    return m_hashColumnSortKey.value(nColumn, SORT_KEY_NONE);
+}
+
 bool XModel::isCustomFilter()
 {
     return false;
@@ -114,26 +262,595 @@ bool XModel::isCustomFilter()
 
 bool XModel::isCustomSort()
 {
-    return false;
+    return !m_hashColumnSortKey.isEmpty();
 }
 
 bool XModel::hasSortKeyHex() const
 {
-    return false;
+    return !m_hashColumnSortKey.isEmpty();
 }
 
 quint64 XModel::getSortKeyHex(qint32 nRow, qint32 nColumn) const
 {
-    Q_UNUSED(nRow)
+    quint64 nResult = 0;
+
+    if (getColumnSortKey(nColumn) == SORT_KEY_NUMBER) {
+        nResult = _getSortColumnKey(_getDataRow(nRow), nColumn);
+    }
+
+    return nResult;
+}
+
+void XModel::sortByColumn(qint32 nColumn, Qt::SortOrder order)
+{
+    SORT_COLUMN sortColumn = {nColumn, order};
+
+    QList<SORT_COLUMN> listColumns;
+    listColumns.append(sortColumn);
+
+    sortByColumns(listColumns);
+}
+
+void XModel::sortByColumns(const QList<SORT_COLUMN> &listColumns)
+{
+    if (m_hashColumnSortKey.isEmpty()) {
+        return;
+    }
+
+    _cancelPartialSort();
+
+    QAtomicInt *pCancelFlag = _resetSortCancel();
+    QList<QVector<quint64>> listKeys;
+
+    if (!_getSortKeys(listColumns, &listKeys, pCancelFlag)) {
+        return;
+    }
+
+    QVector<qint32> vecRowOrder;  // Unsorted columns: natural order
+
+    if (listKeys.count() == 1) {
+        if (_isPartialSort(m_nRowCount)) {
+            vecRowOrder = _startPartialSort(listKeys.at(0));
+        } else {
+            vecRowOrder = getSortPermutation(listKeys.at(0), Qt::AscendingOrder);
+        }
+    } else if (listKeys.count() > 1) {
+        vecRowOrder = getMultiSortPermutation(listKeys, pCancelFlag);
+
+        if (pCancelFlag->loadAcquire()) {
+            return;
+        }
+    }
+
+    _setRowOrder(vecRowOrder);
+}
+
+bool XModel::computeRowOrder(const QList<SORT_COLUMN> &listColumns, QVector<qint32> *pVecRowOrder, QAtomicInt *pCancelFlag) const
+{
+    pVecRowOrder->clear();
+
+    if (m_hashColumnSortKey.isEmpty()) {
+        return true;
+    }
+
+    QList<QVector<quint64>> listKeys;
+
+    if (!_getSortKeys(listColumns, &listKeys, pCancelFlag)) {
+        return false;
+    }
+
+    if (listKeys.count() == 1) {
+        *pVecRowOrder = getSortPermutation(listKeys.at(0), Qt::AscendingOrder);
+    } else if (listKeys.count() > 1) {
+        *pVecRowOrder = getMultiSortPermutation(listKeys, pCancelFlag);
+    }
+
+    return !(pCancelFlag && pCancelFlag->loadAcquire());
+}
+
+void XModel::applyRowOrder(const QVector<qint32> &vecRowOrder)
+{
+    _cancelPartialSort();
+
+    if (vecRowOrder.isEmpty() || (vecRowOrder.count() == m_nRowCount)) {
+        _setRowOrder(vecRowOrder);
+    }
+}
+
+void XModel::_setRowOrder(const QVector<qint32> &vecRowOrder)
+{
+    emit layoutAboutToBeChanged();
+
+    QModelIndexList listFrom = persistentIndexList();
+    QVector<qint32> vecFromDataRows(listFrom.count());
+
+    for (qint32 i = 0; i < listFrom.count(); i++) {
+        vecFromDataRows[i] = _getDataRow(listFrom.at(i).row());
+    }
+
+    qint32 nNumberOfRows = m_nRowCount;
+    m_vecRowOrder = vecRowOrder;
+
+    // Persistent indexes (selection, current index) stay on their records
+    QVector<qint32> vecRowOfDataRow(nNumberOfRows);
+
+    for (qint32 i = 0; i < nNumberOfRows; i++) {
+        vecRowOfDataRow[_getDataRow(i)] = i;
+    }
+
+    QModelIndexList listTo;
+
+    for (qint32 i = 0; i < listFrom.count(); i++) {
+        qint32 nDataRow = vecFromDataRows.at(i);
+        listTo.append(((nDataRow >= 0) && (nDataRow < nNumberOfRows)) ? createIndex(vecRowOfDataRow.at(nDataRow), listFrom.at(i).column()) : QModelIndex());
+    }
+
+    changePersistentIndexList(listFrom, listTo);
+
+    emit layoutChanged();
+}
+
+quint64 XModel::getSignedSortKey(qint64 nValue)
+{
+    return (quint64)nValue ^ 0x8000000000000000ULL;
+}
+
+quint64 XModel::getDoubleSortKey(double dValue)
+{
+    quint64 nBits = 0;
+    memcpy(&nBits, &dValue, sizeof(nBits));
+
+    // IEEE 754: negative values are ordered by the inverted bits, positive ones after them
+    return (nBits & 0x8000000000000000ULL) ? ~nBits : (nBits ^ 0x8000000000000000ULL);
+}
+
+QVector<quint64> XModel::_getColumnSortKeys(qint32 nColumn, QAtomicInt *pCancelFlag) const
+{
+    SORT_KEY sortKey = getColumnSortKey(nColumn);
+    qint32 nNumberOfRows = m_nRowCount;
+    QVector<quint64> vecResult;
+
+    if (sortKey == SORT_KEY_NUMBER) {
+        vecResult.resize(nNumberOfRows);
+
+        for (qint32 i = 0; i < nNumberOfRows; i++) {
+            if (pCancelFlag && ((i & 0xFFFF) == 0) && pCancelFlag->loadAcquire()) {
+                return QVector<quint64>();
+            }
+
+            vecResult[i] = _getSortColumnKey(i, nColumn);
+        }
+    } else if (sortKey == SORT_KEY_TEXT) {
+        // The distinct strings are ranked once, the radix sort orders the ranks
+        QVector<QString> vecTexts(nNumberOfRows);
+        QVector<qint32> vecOrder(nNumberOfRows);
+
+        for (qint32 i = 0; i < nNumberOfRows; i++) {
+            if (pCancelFlag && ((i & 0xFFFF) == 0) && pCancelFlag->loadAcquire()) {
+                return QVector<quint64>();
+            }
+
+            vecTexts[i] = _getSortColumnText(i, nColumn);
+            vecOrder[i] = i;
+        }
+
+        XModelTextLess textLess;
+        textLess.pVecTexts = &vecTexts;
+        std::sort(vecOrder.begin(), vecOrder.end(), textLess);
+
+        vecResult.resize(nNumberOfRows);
+        quint64 nRank = 0;
+
+        for (qint32 i = 0; i < nNumberOfRows; i++) {
+            if ((i > 0) && (vecTexts.at(vecOrder.at(i - 1)) != vecTexts.at(vecOrder.at(i)))) {
+                nRank++;
+            }
+
+            vecResult[vecOrder.at(i)] = nRank;
+        }
+    }
+
+    return vecResult;
+}
+
+bool XModel::_getSortKeys(const QList<SORT_COLUMN> &listColumns, QList<QVector<quint64>> *pListKeys, QAtomicInt *pCancelFlag) const
+{
+    qint32 nNumberOfRows = m_nRowCount;
+
+    for (qint32 i = 0; i < listColumns.count(); i++) {
+        QVector<quint64> vecKeys = _getColumnSortKeys(listColumns.at(i).nColumn, pCancelFlag);
+
+        if (pCancelFlag && pCancelFlag->loadAcquire()) {
+            return false;
+        }
+
+        if (vecKeys.isEmpty()) {
+            continue;
+        }
+
+        if (listColumns.at(i).order == Qt::DescendingOrder) {
+            for (qint32 j = 0; j < nNumberOfRows; j++) {
+                vecKeys[j] = ~vecKeys.at(j);
+            }
+        }
+
+        pListKeys->append(vecKeys);
+    }
+
+    return true;
+}
+
+quint64 XModel::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
+{
+    Q_UNUSED(nDataRow)
     Q_UNUSED(nColumn)
 
     return 0;
 }
 
-void XModel::sortByColumn(qint32 nColumn, Qt::SortOrder order)
+QString XModel::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
+{
+    Q_UNUSED(nDataRow)
+    Q_UNUSED(nColumn)
+
+    return QString();
+}
+
+qint32 XModel::_getDataRow(qint32 nRow) const
+{
+    return m_vecRowOrder.isEmpty() ? nRow : m_vecRowOrder.at(nRow);
+}
+
+QVector<qint32> XModel::getSortPermutation(const QVector<quint64> &vecKeys, Qt::SortOrder order)
+{
+    qint32 nCount = vecKeys.count();
+    QVector<qint32> vecIndex(nCount);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        vecIndex[i] = i;
+    }
+
+    // Descending order is an ascending sort of the inverted keys; the stable passes keep equal keys in row order
+    QVector<quint64> vecSortKeys = vecKeys;
+
+    if (order == Qt::DescendingOrder) {
+        for (qint32 i = 0; i < nCount; i++) {
+            vecSortKeys[i] = ~vecSortKeys.at(i);
+        }
+    }
+
+    bool bSorted = true;
+    bool bReverseSorted = (nCount > 1);
+
+    for (qint32 i = 1; (i < nCount) && (bSorted || bReverseSorted); i++) {
+        bSorted = bSorted && (vecSortKeys.at(i - 1) <= vecSortKeys.at(i));
+        bReverseSorted = bReverseSorted && (vecSortKeys.at(i - 1) > vecSortKeys.at(i));  // Strict: equal keys would change their order
+    }
+
+    if (bSorted) {
+        return vecIndex;
+    }
+
+    if (bReverseSorted) {
+        std::reverse(vecIndex.begin(), vecIndex.end());
+        return vecIndex;
+    }
+
+    qint32 nNumberOfChunks = 1;
+
+    if (nCount >= N_RADIX_PARALLEL_THRESHOLD) {
+        nNumberOfChunks = qMax(1, QThread::idealThreadCount());
+    }
+
+    qint32 nChunkSize = (nCount + nNumberOfChunks - 1) / nNumberOfChunks;
+    QVector<qint32> vecChunks(nNumberOfChunks);
+
+    for (qint32 i = 0; i < nNumberOfChunks; i++) {
+        vecChunks[i] = i;
+    }
+
+    QVector<quint64> vecKeysOut(nCount);
+    QVector<qint32> vecIndexOut(nCount);
+    QVector<qint64> vecCounts(nNumberOfChunks * 256);
+
+    for (qint32 nShift = 0; nShift < 64; nShift += 8) {
+        vecCounts.fill(0);
+
+        XModelRadixChunk functorChunk;
+        functorChunk.pKeys = vecSortKeys.constData();
+        functorChunk.pIndex = vecIndex.constData();
+        functorChunk.pKeysOut = vecKeysOut.data();
+        functorChunk.pIndexOut = vecIndexOut.data();
+        functorChunk.pCounts = vecCounts.data();
+        functorChunk.nShift = nShift;
+        functorChunk.nChunkSize = nChunkSize;
+        functorChunk.nCount = nCount;
+        functorChunk.bScatter = false;
+
+        if (nNumberOfChunks > 1) {
+            QtConcurrent::blockingMap(vecChunks, functorChunk);
+        } else {
+            functorChunk(0);
+        }
+
+        // Chunk c of digit d starts after all smaller digits and after digit d of the chunks before c
+        qint64 nPosition = 0;
+        bool bSkip = false;
+
+        for (qint32 nDigit = 0; nDigit < 256; nDigit++) {
+            qint64 nDigitCount = 0;
+
+            for (qint32 i = 0; i < nNumberOfChunks; i++) {
+                qint64 nChunkCount = vecCounts.at(i * 256 + nDigit);
+                vecCounts[i * 256 + nDigit] = nPosition;
+                nPosition += nChunkCount;
+                nDigitCount += nChunkCount;
+            }
+
+            if (nDigitCount == nCount) {
+                bSkip = true;  // Every key has this digit: the pass would not move anything
+            }
+        }
+
+        if (bSkip) {
+            continue;
+        }
+
+        functorChunk.bScatter = true;
+
+        if (nNumberOfChunks > 1) {
+            QtConcurrent::blockingMap(vecChunks, functorChunk);
+        } else {
+            functorChunk(0);
+        }
+
+        vecSortKeys.swap(vecKeysOut);
+        vecIndex.swap(vecIndexOut);
+    }
+
+    return vecIndex;
+}
+
+QVector<qint32> XModel::getMultiSortPermutation(const QList<QVector<quint64>> &listKeys, QAtomicInt *pCancelFlag)
+{
+    qint32 nNumberOfKeys = listKeys.count();
+    qint32 nCount = nNumberOfKeys ? listKeys.at(0).count() : 0;
+
+    // Significant bits of every key once rebased to the minimum of its column
+    QVector<quint64> vecMin(nNumberOfKeys);
+    QVector<qint32> vecBits(nNumberOfKeys);
+
+    for (qint32 i = 0; i < nNumberOfKeys; i++) {
+        const QVector<quint64> &vecKeys = listKeys.at(i);
+        quint64 nMin = (quint64)-1;
+        quint64 nMax = 0;
+
+        for (qint32 j = 0; j < nCount; j++) {
+            nMin = qMin(nMin, vecKeys.at(j));
+            nMax = qMax(nMax, vecKeys.at(j));
+        }
+
+        quint64 nRange = nCount ? (nMax - nMin) : 0;
+        qint32 nBits = 0;
+
+        while (nRange) {
+            nBits++;
+            nRange >>= 1;
+        }
+
+        vecMin[i] = nCount ? nMin : 0;
+        vecBits[i] = nBits;
+    }
+
+    // Words of consecutive keys, most significant first: vecWordStart[w] is the first key of word w
+    QVector<qint32> vecWordStart;
+    qint32 nWordBits = 0;
+
+    for (qint32 i = 0; i < nNumberOfKeys; i++) {
+        if ((i == 0) || (nWordBits + vecBits.at(i) > 64)) {
+            vecWordStart.append(i);
+            nWordBits = 0;
+        }
+
+        nWordBits += vecBits.at(i);
+    }
+
+    QVector<qint32> vecResult(nCount);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        vecResult[i] = i;
+    }
+
+    // LSD over the words: one stable sort per word, the least significant word first
+    QVector<quint64> vecWords(nCount);
+    QVector<qint32> vecNext(nCount);
+
+    for (qint32 w = vecWordStart.count() - 1; w >= 0; w--) {
+        if (pCancelFlag && pCancelFlag->loadAcquire()) {
+            return QVector<qint32>();
+        }
+
+        qint32 nFirstKey = vecWordStart.at(w);
+        qint32 nLastKey = (w + 1 < vecWordStart.count()) ? vecWordStart.at(w + 1) : nNumberOfKeys;
+
+        for (qint32 i = 0; i < nCount; i++) {
+            qint32 nRow = vecResult.at(i);
+            quint64 nWord = 0;
+
+            for (qint32 k = nFirstKey; k < nLastKey; k++) {
+                nWord = ((vecBits.at(k) < 64) ? (nWord << vecBits.at(k)) : 0) | (listKeys.at(k).at(nRow) - vecMin.at(k));
+            }
+
+            vecWords[i] = nWord;
+        }
+
+        QVector<qint32> vecPermutation = getSortPermutation(vecWords, Qt::AscendingOrder);
+
+        for (qint32 i = 0; i < nCount; i++) {
+            vecNext[i] = vecResult.at(vecPermutation.at(i));
+        }
+
+        vecResult.swap(vecNext);
+    }
+
+    return vecResult;
+}
+
+QVector<qint32> XModel::getTopPermutation(const QVector<quint64> &vecKeys, qint32 nTopRows)
+{
+    qint32 nCount = vecKeys.count();
+    nTopRows = qBound(0, nTopRows, nCount);
+
+    // Max-heap of the nTopRows smallest (key, row) pairs; the row breaks ties, so the selection is stable
+    QVector<QPair<quint64, qint32>> vecHeap;
+    vecHeap.reserve(nTopRows);
+
+    for (qint32 i = 0; (i < nCount) && (nTopRows > 0); i++) {
+        QPair<quint64, qint32> record(vecKeys.at(i), i);
+
+        if (vecHeap.count() < nTopRows) {
+            vecHeap.append(record);
+            std::push_heap(vecHeap.begin(), vecHeap.end());
+        } else if (record < vecHeap.first()) {
+            std::pop_heap(vecHeap.begin(), vecHeap.end());
+            vecHeap.last() = record;
+            std::push_heap(vecHeap.begin(), vecHeap.end());
+        }
+    }
+
+    std::sort_heap(vecHeap.begin(), vecHeap.end());
+
+    QVector<qint32> vecResult;
+    vecResult.reserve(nCount);
+    QVector<bool> vecTop(nCount, false);
+
+    for (qint32 i = 0; i < vecHeap.count(); i++) {
+        vecResult.append(vecHeap.at(i).second);
+        vecTop[vecHeap.at(i).second] = true;
+    }
+
+    for (qint32 i = 0; i < nCount; i++) {
+        if (!vecTop.at(i)) {
+            vecResult.append(i);
+        }
+    }
+
+    return vecResult;
+}
+
+void XModel::setPartialSortEnabled(bool bEnabled, qint32 nTopRows)
+{
+    m_bPartialSortEnabled = bEnabled;
+    m_nPartialSortRows = nTopRows;
+
+    if (!bEnabled) {
+        _cancelPartialSort();
+    }
+}
+
+bool XModel::isPartialSortEnabled() const
+{
+    return m_bPartialSortEnabled;
+}
+
+bool XModel::isPartialSortPending() const
+{
+    return m_bPartialSortPending;
+}
+
+void XModel::cancelSort()
+{
+    m_nSortCancel.storeRelease(1);
+}
+
+QAtomicInt *XModel::_resetSortCancel()
+{
+    m_nSortCancel.storeRelease(0);
+
+    return &m_nSortCancel;
+}
+
+bool XModel::_isPartialSort(qint32 nRowCount) const
+{
+    return m_bPartialSortEnabled && (m_nPartialSortRows > 0) && (nRowCount >= qMax(N_PARTIAL_SORT_THRESHOLD, 4 * m_nPartialSortRows));
+}
+
+static QVector<qint32> _xmodelReversedSortPermutation(const QVector<quint64> &vecKeys)
+{
+    QVector<qint32> vecIndex = XModel::getSortPermutation(vecKeys, Qt::AscendingOrder);
+    std::reverse(vecIndex.begin(), vecIndex.end());
+
+    return vecIndex;
+}
+
+QVector<qint32> XModel::_startPartialSort(const QVector<quint64> &vecKeys, Qt::SortOrder order)
+{
+    if (!m_pPartialSortWatcher) {
+        m_pPartialSortWatcher = new QFutureWatcher<QVector<qint32>>(this);
+        connect(m_pPartialSortWatcher, SIGNAL(finished()), this, SLOT(_onPartialSortFinished()));
+    }
+
+    // The worker owns a copy of the keys and never reads the model; setFuture() drops a previous run
+    m_bPartialSortPending = true;
+
+    if (order == Qt::AscendingOrder) {
+        m_pPartialSortWatcher->setFuture(QtConcurrent::run(&XModel::getSortPermutation, vecKeys, Qt::AscendingOrder));
+
+        return getTopPermutation(vecKeys, m_nPartialSortRows);
+    }
+
+    m_pPartialSortWatcher->setFuture(QtConcurrent::run(_xmodelReversedSortPermutation, vecKeys));
+
+    // The first rows of the reversed ascending order: the largest keys, equal keys from the last row.
+    // That is the ascending top of the inverted keys taken in reverse row order.
+    qint32 nCount = vecKeys.count();
+    QVector<quint64> vecReversedKeys(nCount);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        vecReversedKeys[i] = ~vecKeys.at(nCount - 1 - i);
+    }
+
+    QVector<qint32> vecResult = getTopPermutation(vecReversedKeys, m_nPartialSortRows);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        vecResult[i] = nCount - 1 - vecResult.at(i);
+    }
+
+    return vecResult;
+}
+
+void XModel::_cancelPartialSort()
+{
+    m_bPartialSortPending = false;
+}
+
+void XModel::_applyPartialSortResult(const QVector<qint32> &vecIndex)
+{
+    _setRowOrder(vecIndex);
+}
+
+void XModel::_onPartialSortFinished()
+{
+    if (!m_bPartialSortPending) {
+        return;  // Canceled: another sort, a new row count or changed values
+    }
+
+    m_bPartialSortPending = false;
+
+    QVector<qint32> vecIndex = m_pPartialSortWatcher->result();
+
+    if (vecIndex.count() == m_nRowCount) {
+        _applyPartialSortResult(vecIndex);
+    }
+}
+
+bool XModel::getColumnValueIds(qint32 nColumn, QVector<quint32> *pVecIds, QVector<QString> *pVecValues) const
 {
     Q_UNUSED(nColumn)
-    Q_UNUSED(order)
+    Q_UNUSED(pVecIds)
+    Q_UNUSED(pVecValues)
+
+    return false;
 }
 
 void XModel::setRowHidden(qint32 nRow, bool bState)
@@ -203,12 +920,23 @@ QModelIndex XModel::parent(const QModelIndex &child) const
 void XModel::_setRowCount(qint32 nRowCount)
 {
     beginResetModel();
+    _cancelPartialSort();
     m_nRowCount = nRowCount;
+    m_vecRowOrder.clear();
     m_vecRowHidden.resize(nRowCount);
     m_vecRowHidden.fill(false);
     endResetModel();
 }
 
+void XModel::_changeRowCount(qint32 nRowCount)
+{
+    _cancelPartialSort();
+    m_nRowCount = nRowCount;
+    m_vecRowOrder.clear();
+    m_vecRowHidden.resize(nRowCount);
+    m_vecRowHidden.fill(false);
+}
+
 void XModel::_setColumnCount(qint32 nColumnCount)
 {
     beginResetModel();
@@ -234,7 +962,7 @@ int XModel::columnCount(const QModelIndex &parent) const
     return m_nColumnCount;
 }
 
-void XModel::adjustColumnToContent(qint32 nColumn, bool bHeader)
+void XModel::adjustColumnToContent(qint32 nColumn, bool bHeader, qint32 nVisibleRow, qint32 nVisibleCount)
 {
     qint32 nSymbolSize = 0;
 
@@ -242,27 +970,50 @@ void XModel::adjustColumnToContent(qint32 nColumn, bool bHeader)
         nSymbolSize = qMax(nSymbolSize, headerData(nColumn, Qt::Horizontal).toString().length());
     }
 
-    qint32 nNumberOfRows = rowCount();
+    qint32 nHint = _getColumnSymbolHint(nColumn);
 
-    for (qint32 i = 0; i < nNumberOfRows; i++) {
-        QModelIndex index = this->index(i, nColumn);
-        QString sData = data(index, Qt::DisplayRole).toString();
+    if (nHint >= 0) {
+        nSymbolSize = qMax(nSymbolSize, nHint);
+    } else {
+        qint32 nNumberOfRows = rowCount();
+        QVector<qint32> vecRows;
+
+        if (nNumberOfRows > N_ADJUST_FULL_LIMIT) {
+            vecRows = _getAdjustSampleRows(nNumberOfRows, nColumn, nVisibleRow, nVisibleCount);
+            nNumberOfRows = vecRows.count();
+        }
 
-        nSymbolSize = qMax(nSymbolSize, sData.length());
+        beginBulkAccess();
+
+        for (qint32 i = 0; i < nNumberOfRows; i++) {
+            QModelIndex index = this->index(vecRows.isEmpty() ? i : vecRows.at(i), nColumn);
+            QString sData = data(index, Qt::DisplayRole).toString();
+
+            nSymbolSize = qMax(nSymbolSize, sData.length());
+        }
+
+        endBulkAccess();
     }
 
     setColumnSymbolSize(nColumn, nSymbolSize);
 }
 
-void XModel::adjustColumnsToContent(bool bHeader)
+void XModel::adjustColumnsToContent(bool bHeader, qint32 nVisibleRow, qint32 nVisibleCount)
 {
     qint32 nNumberOfColumns = columnCount();
 
     for (qint32 i = 0; i < nNumberOfColumns; i++) {
-        adjustColumnToContent(i, bHeader);
+        adjustColumnToContent(i, bHeader, nVisibleRow, nVisibleCount);
     }
 }
 
+qint32 XModel::_getColumnSymbolHint(qint32 nColumn) const
+{
+    Q_UNUSED(nColumn)
+
+    return -1;
+}
+
 QString XModel::toXML() const
 {
     QString sResult;
@@ -275,6 +1026,8 @@ QString XModel::toXML() const
     const qint32 nNumberOfRows = rowCount();
     const qint32 nNumberOfColumns = columnCount();
 
+    beginBulkAccess();
+
     for (qint32 nRow = 0; nRow < nNumberOfRows; nRow++) {
         if ((nRow < m_vecRowHidden.size()) && m_vecRowHidden.at(nRow)) {
             continue;
@@ -292,6 +1045,8 @@ QString XModel::toXML() const
         xmlWriter.writeEndElement();
     }
 
+    endBulkAccess();
+
     xmlWriter.writeEndElement();
     xmlWriter.writeEndDocument();
 
@@ -305,6 +1060,8 @@ QString XModel::toJSON() const
     const qint32 nNumberOfRows = rowCount();
     const qint32 nNumberOfColumns = columnCount();
 
+    beginBulkAccess();
+
     for (qint32 nRow = 0; nRow < nNumberOfRows; nRow++) {
         if ((nRow < m_vecRowHidden.size()) && m_vecRowHidden.at(nRow)) {
             continue;
@@ -322,14 +1079,221 @@ QString XModel::toJSON() const
         jsonRows.append(jsonRow);
     }
 
+    endBulkAccess();
+
     QJsonDocument jsonDocument(jsonRows);
 
     return jsonDocument.toJson(QJsonDocument::Indented);
 }
 
-XModel::SORT_METHOD XModel::getSortMethod(qint32 nColumn)
+void XModel::setDisplayCacheEnabled(bool bEnabled, qint64 nBudget)
 {
-    Q_UNUSED(nColumn)
+    clearDisplayCache();
+
+    m_bDisplayCacheEnabled = bEnabled;
+    m_nDisplayCacheBudget = nBudget;
+}
+
+bool XModel::isDisplayCacheEnabled() const
+{
+    return m_bDisplayCacheEnabled;
+}
+
+void XModel::setColumnDisplayCache(qint32 nColumn, bool bState)
+{
+    m_hashColumnDisplayCache[nColumn] = bState;
+}
+
+void XModel::clearDisplayCache()
+{
+    QMutexLocker locker(&m_displayCacheMutex);
+
+    m_vecDisplayCache.clear();
+    m_nDisplayCacheSize = 0;
+}
+
+void XModel::setMemoryBudget(qint64 nBytes)
+{
+    g_nMemoryBudget = nBytes;
+}
+
+qint64 XModel::getMemoryBudget()
+{
+    return g_nMemoryBudget;
+}
+
+void XModel::setViewed()
+{
+    m_nLastViewed = ++g_nViewCounter;
+
+    if (g_nMemoryBudget <= 0) {
+        return;
+    }
+
+    qint64 nTotalSize = 0;
+    QList<QPair<quint64, XModel *>> listCandidates;
+    qint32 nNumberOfModels = g_listMemoryModels.count();
+
+    for (qint32 i = 0; i < nNumberOfModels; i++) {
+        XModel *pModel = g_listMemoryModels.at(i);
+        qint64 nSize = pModel->getResidentSize();
+
+        nTotalSize += nSize;
+
+        if ((pModel != this) && !pModel->isBusy() && (nSize > 0)) {
+            listCandidates.append(qMakePair(pModel->m_nLastViewed, pModel));
+        }
+    }
+
+    std::sort(listCandidates.begin(), listCandidates.end(), _compareLastViewed);
+
+    for (qint32 i = 0; (i < listCandidates.count()) && (nTotalSize > g_nMemoryBudget); i++) {
+        XModel *pModel = listCandidates.at(i).second;
+        qint64 nSize = pModel->getResidentSize();
+
+        pModel->releaseMemory();
+
+        nTotalSize -= (nSize - pModel->getResidentSize());
+    }
+}
+
+void XModel::setBusy(bool bBusy)
+{
+    m_bBusy = bBusy;
+}
+
+bool XModel::isBusy() const
+{
+    return m_bBusy;
+}
+
+qint64 XModel::getResidentSize() const
+{
+    QMutexLocker locker(&m_displayCacheMutex);
+
+    // The row state (hidden rows, row order) stays: releaseMemory() cannot free it
+    return m_nDisplayCacheSize;
+}
+
+void XModel::releaseMemory()
+{
+    clearDisplayCache();
+}
+
+void XModel::beginBulkAccess() const
+{
+    m_nBulkAccess.ref();
+}
 
-    return SORT_METHOD_DEFAULT;
+void XModel::endBulkAccess() const
+{
+    m_nBulkAccess.deref();
+}
+
+bool XModel::isBulkAccess() const
+{
+    return m_nBulkAccess.loadAcquire() > 0;
+}
+
+bool XModel::_getDisplayCache(qint32 nRow, qint32 nColumn, QVariant *pResult) const
+{
+    if (!m_bDisplayCacheEnabled) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_displayCacheMutex);
+
+    if ((nColumn >= 0) && (nColumn < m_vecDisplayCache.count())) {
+        const DISPLAY_CACHE &cache = m_vecDisplayCache.at(nColumn);
+
+        if ((nRow >= 0) && (nRow < cache.vecIndex.count())) {
+            quint64 nPacked = cache.vecIndex.at(nRow);
+
+            if (nPacked != N_DISPLAY_CACHE_EMPTY) {
+                *pResult = QString(cache.vecArena.constData() + (nPacked >> 16), (qint32)(nPacked & 0xFFFF));
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void XModel::_setDisplayCache(qint32 nRow, qint32 nColumn, const QVariant &varValue) const
+{
+    if (!m_bDisplayCacheEnabled || !m_hashColumnDisplayCache.value(nColumn, false) || (varValue.userType() != QMetaType::QString)) {
+        return;
+    }
+
+    const QString sValue = varValue.toString();
+    qint32 nLength = sValue.length();
+
+    if ((nRow < 0) || (nRow >= m_nRowCount) || (nColumn < 0) || (nColumn >= m_nColumnCount) || (nLength > 0xFFFF)) {
+        return;
+    }
+
+    QMutexLocker locker(&m_displayCacheMutex);
+
+    // The row index of a column (8 bytes per row) is charged to the budget like the text
+    qint64 nIndexSize = (qint64)m_nRowCount * (qint64)sizeof(quint64);
+    qint64 nTextSize = (qint64)nLength * (qint64)sizeof(QChar);
+    bool bNewIndex = (nColumn >= m_vecDisplayCache.count()) || m_vecDisplayCache.at(nColumn).vecIndex.isEmpty();
+
+    if (m_nDisplayCacheSize + nTextSize + (bNewIndex ? nIndexSize : 0) > m_nDisplayCacheBudget) {
+        // Over budget: start over, the visible rows are formatted again on demand
+        m_vecDisplayCache.clear();
+        m_nDisplayCacheSize = 0;
+
+        if (nTextSize + nIndexSize > m_nDisplayCacheBudget) {
+            // The index alone does not fit: this column is not cached
+            return;
+        }
+    }
+
+    if (m_vecDisplayCache.count() != m_nColumnCount) {
+        m_vecDisplayCache.resize(m_nColumnCount);
+    }
+
+    DISPLAY_CACHE &cache = m_vecDisplayCache[nColumn];
+
+    if (cache.vecIndex.isEmpty()) {
+        cache.vecIndex.fill(N_DISPLAY_CACHE_EMPTY, m_nRowCount);
+        m_nDisplayCacheSize += nIndexSize;
+    }
+
+    if (cache.vecIndex.at(nRow) == N_DISPLAY_CACHE_EMPTY) {
+        quint64 nOffset = cache.vecArena.count();
+
+        cache.vecArena.resize((qint32)nOffset + nLength);
+        memcpy(cache.vecArena.data() + nOffset, sValue.constData(), nLength * sizeof(QChar));
+        cache.vecIndex[nRow] = (nOffset << 16) | (quint64)nLength;
+        m_nDisplayCacheSize += nTextSize;
+    }
+}
+
+void XModel::_invalidateDisplayCache(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    QMutexLocker locker(&m_displayCacheMutex);
+
+    if (m_vecDisplayCache.isEmpty() || !topLeft.isValid() || !bottomRight.isValid()) {
+        return;
+    }
+
+    qint32 nLastColumn = qMin(bottomRight.column(), m_vecDisplayCache.count() - 1);
+
+    for (qint32 i = qMax(topLeft.column(), 0); i <= nLastColumn; i++) {
+        DISPLAY_CACHE &cache = m_vecDisplayCache[i];
+        qint32 nLastRow = qMin(bottomRight.row(), cache.vecIndex.count() - 1);
+
+        // The old text stays in the arena until the next clear; only the row index is reset
+        for (qint32 j = qMax(topLeft.row(), 0); j <= nLastRow; j++) {
+            cache.vecIndex[j] = N_DISPLAY_CACHE_EMPTY;
+        }
+    }
+}
+
+XModel::SORT_METHOD XModel::getSortMethod(qint32 nColumn)
+{
+    return (getColumnSortKey(nColumn) == SORT_KEY_NUMBER) ? SORT_METHOD_HEX : SORT_METHOD_DEFAULT;
 }
@@ -23,6 +23,10 @@
 #define XMODEL_H
 
 #include <QAbstractItemModel>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QVariant>
 #include <QVector>
 
 class XModel : public QAbstractItemModel {
@@ -34,13 +38,27 @@ public:
         SORT_METHOD_HEX,
     };
 
+    // Declarative native sort: columns marked with setColumnSortKey() are sorted by the model itself
+    // (isCustomSort()) from the keys of _getSortColumnKey()/_getSortColumnText(); data() maps rows with _getDataRow()
+    enum SORT_KEY {
+        SORT_KEY_NONE = 0,
+        SORT_KEY_NUMBER,  // Order-preserving unsigned key
+        SORT_KEY_TEXT     // Same order as the proxy's string comparison
+    };
+
+    struct SORT_COLUMN {
+        qint32 nColumn;
+        Qt::SortOrder order;
+    };
+
     enum USERROLE {
         USERROLE_ORIGINDEX = 0,
         USERROLE_SIZE,
         USERROLE_OFFSET,
         USERROLE_ADDRESS,
         USERROLE_STRING1,
-        USERROLE_STRING2
+        USERROLE_STRING2,
+        USERROLE_FETCHED  // dataChanged() role of lazily fetched cells: only the shown text changes, bulk readers had the value
     };
 
     explicit XModel(QObject *pParent);
@@ -52,12 +70,40 @@ public:
     qint32 getColumnAlignment(qint32 nColumn) const;
     void setColumnName(qint32 nColumn, const QString &sName);
     QString getColumnName(qint32 nColumn) const;
+    void setColumnSortKey(qint32 nColumn, SORT_KEY sortKey);
+    SORT_KEY getColumnSortKey(qint32 nColumn) const;
     virtual SORT_METHOD getSortMethod(qint32 nColumn);
     virtual bool isCustomFilter();
     virtual bool isCustomSort();
     virtual bool hasSortKeyHex() const;
     virtual quint64 getSortKeyHex(qint32 nRow, qint32 nColumn) const;
     virtual void sortByColumn(qint32 nColumn, Qt::SortOrder order);
+    // Stable sort by several columns, the first one is the primary key; columns without a sort key are ignored
+    virtual void sortByColumns(const QList<SORT_COLUMN> &listColumns);
+    // sortByColumns() in two steps for the threaded view: the order is computed on a worker (reads only the sort keys,
+    // the model must not change meanwhile) and applied on the GUI thread. false if pCancelFlag was set.
+    virtual bool computeRowOrder(const QList<SORT_COLUMN> &listColumns, QVector<qint32> *pVecRowOrder, QAtomicInt *pCancelFlag = nullptr) const;
+    virtual void applyRowOrder(const QVector<qint32> &vecRowOrder);  // Empty: natural order
+    void cancelSort();  // Thread-safe: a running sortByColumns() stops and keeps the current order
+    // Interned column: pVecIds gets one id per row into pVecValues, the distinct display strings,
+    // so filter/sort can evaluate every distinct value once. false if the column is not interned.
+    virtual bool getColumnValueIds(qint32 nColumn, QVector<quint32> *pVecIds, QVector<QString> *pVecValues) const;
+    // Stable permutation of the row indexes that orders vecKeys (equal keys keep the row order in both orders).
+    // LSD radix sort, 8 bits per pass; sorted/reverse sorted keys are detected in O(n), big inputs run in parallel.
+    static QVector<qint32> getSortPermutation(const QVector<quint64> &vecKeys, Qt::SortOrder order);
+    // Stable ascending permutation by the composite key (listKeys[0][i], listKeys[1][i], ...); descending keys
+    // are passed inverted. The keys are rebased to their minimum and packed into as few 64-bit words as their
+    // ranges allow (two keys up to 128 bits are one or two radix sorts). Empty if pCancelFlag was set.
+    static QVector<qint32> getMultiSortPermutation(const QList<QVector<quint64>> &listKeys, QAtomicInt *pCancelFlag = nullptr);
+    // Ascending order of the nTopRows smallest keys (stable, heap selection in O(n log K)), then the other rows in row order
+    static QVector<qint32> getTopPermutation(const QVector<quint64> &vecKeys, qint32 nTopRows);
+    static quint64 getSignedSortKey(qint64 nValue);  // Unsigned key with the order of the signed value
+    static quint64 getDoubleSortKey(double dValue);  // Unsigned key with the order of the double value
+    // Opt-in partial sort for big models: a single column sort shows the first nTopRows rows at once (getTopPermutation())
+    // while the full order is computed on the thread pool; it is swapped in with layoutChanged, the top rows do not move
+    void setPartialSortEnabled(bool bEnabled, qint32 nTopRows = 0x400);
+    bool isPartialSortEnabled() const;
+    bool isPartialSortPending() const;
     void setRowHidden(qint32 nRow, bool bState);
     void clearRowHidden();
     qint32 getVisibleRowCount() const;
@@ -71,20 +117,150 @@ public:
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     virtual int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
-    void adjustColumnToContent(qint32 nColumn, bool bHeader);
-    void adjustColumnsToContent(bool bHeader);
+    // Sets the symbol size to the widest text of the column: typed columns answer from _getColumnSymbolHint(),
+    // big models are sampled (first, last, visible and strided rows) instead of formatting every cell
+    void adjustColumnToContent(qint32 nColumn, bool bHeader, qint32 nVisibleRow = -1, qint32 nVisibleCount = 0);
+    void adjustColumnsToContent(bool bHeader, qint32 nVisibleRow = -1, qint32 nVisibleCount = 0);
 
     virtual QString toXML() const;
     virtual QString toJSON() const;
 
+    // Opt-in display string cache: the DisplayRole strings of the columns marked with
+    // setColumnDisplayCache() are formatted once and then shared by filter, sort and paint.
+    // Stored per column in a UTF-16 arena; dropped on reset/layout change, per row on dataChanged.
+    void setDisplayCacheEnabled(bool bEnabled, qint64 nBudget = 0x4000000);
+    bool isDisplayCacheEnabled() const;
+    void setColumnDisplayCache(qint32 nColumn, bool bState);
+    void clearDisplayCache();
+
+    // Process-wide memory budget shared by all models (0 = unlimited). When the models are over it,
+    // setViewed() makes the least recently viewed idle models release their caches; they are rebuilt on access.
+    static void setMemoryBudget(qint64 nBytes);
+    static qint64 getMemoryBudget();
+    void setViewed();
+    void setBusy(bool bBusy);  // Set by the view while worker threads read the model; busy models are never released
+    bool isBusy() const;
+    virtual qint64 getResidentSize() const;  // Bytes of the caches that releaseMemory() frees; what it cannot free is not counted
+    virtual void releaseMemory();
+    // GUI thread, before the model is deleted on another thread: leaves the budget registry and stops the background
+    // work, so only plain memory is left to release there
+    virtual void prepareForDeferredDelete();
+
+    // Bulk readers (filter/sort caches, export, width adjust) need the real values: models that fetch
+    // cells lazily resolve them synchronously while a bulk access is open. Thread-safe and nestable.
+    void beginBulkAccess() const;
+    void endBulkAccess() const;
+    bool isBulkAccess() const;
+
+protected:
+    virtual qint32 _getColumnSymbolHint(qint32 nColumn) const;  // Widest display text of the column in O(1); -1: unknown, sampled
+    virtual quint64 _getSortColumnKey(qint32 nDataRow, qint32 nColumn) const;
+    virtual QString _getSortColumnText(qint32 nDataRow, qint32 nColumn) const;
+    qint32 _getDataRow(qint32 nRow) const;  // Record index of a model row in the current sort order
+    // Per record, equal values get equal keys; empty: no sort key or canceled
+    QVector<quint64> _getColumnSortKeys(qint32 nColumn, QAtomicInt *pCancelFlag = nullptr) const;
+    bool _getSortKeys(const QList<SORT_COLUMN> &listColumns, QList<QVector<quint64>> *pListKeys, QAtomicInt *pCancelFlag = nullptr) const;
+    QAtomicInt *_resetSortCancel();  // Cancel flag of a synchronous sort, set by cancelSort()
+    void _setRowOrder(const QVector<qint32> &vecRowOrder);      // Emits the layout change, persistent indexes stay on their records
+    bool _isPartialSort(qint32 nRowCount) const;
+    // Top rows now, the rest in the background. Descending is the reversed ascending order (equal keys from the last row)
+    QVector<qint32> _startPartialSort(const QVector<quint64> &vecKeys, Qt::SortOrder order = Qt::AscendingOrder);
+    void _cancelPartialSort();  // The running background sort will not be applied
+    virtual void _applyPartialSortResult(const QVector<qint32> &vecIndex);  // GUI thread: the full order of _startPartialSort()
+    void _changeRowCount(qint32 nRowCount);  // Inside layoutAboutToBeChanged()/layoutChanged(): no model reset
+    bool _getDisplayCache(qint32 nRow, qint32 nColumn, QVariant *pResult) const;
+    void _setDisplayCache(qint32 nRow, qint32 nColumn, const QVariant &varValue) const;
+
+private slots:
+    void _invalidateDisplayCache(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void _onPartialSortFinished();
+
 private:
+    struct DISPLAY_CACHE {
+        QVector<quint64> vecIndex;  // Per row: (nOffset << 16) | nLength in vecArena
+        QVector<QChar> vecArena;
+    };
+
     QVector<bool> m_vecRowHidden;
     QHash<qint32, quint64> m_hashRowPrio;
     QHash<qint32, qint32> m_hashColumnSymbolSize;
     QHash<qint32, qint32> m_hashColumnAlignment;
     QHash<qint32, QString> m_hashColumnName;
+    QHash<qint32, SORT_KEY> m_hashColumnSortKey;
+    QVector<qint32> m_vecRowOrder;  // Empty: natural order
     qint32 m_nRowCount;
     qint32 m_nColumnCount;
+    QHash<qint32, bool> m_hashColumnDisplayCache;
+    bool m_bDisplayCacheEnabled;
+    qint64 m_nDisplayCacheBudget;
+    mutable qint64 m_nDisplayCacheSize;
+    mutable QVector<DISPLAY_CACHE> m_vecDisplayCache;
+    mutable QMutex m_displayCacheMutex;  // data() may run on the filter/sort cache threads
+    quint64 m_nLastViewed;
+    bool m_bBusy;
+    bool m_bMemoryRegistered;
+    mutable QAtomicInt m_nBulkAccess;
+    bool m_bPartialSortEnabled;
+    qint32 m_nPartialSortRows;
+    bool m_bPartialSortPending;
+    QFutureWatcher<QVector<qint32>> *m_pPartialSortWatcher;
+    QAtomicInt m_nSortCancel;
+};
+
+// Column descriptor table of a model over a list of RECORD, one entry per column in column order.
+// _initColumns() registers it with init(); data(), the sort keys, filtering, export and width
+// estimation all read a cell through the same accessor.
+template <class RECORD>
+class XModelColumns {
+public:
+    struct COLUMN {
+        const char *pszName;  // QT_TRANSLATE_NOOP("QObject", ...)
+        qint32 nAlignment;
+        qint32 nSymbolSize;
+        XModel::SORT_KEY sortKey;
+        QVariant (*pDisplay)(const RECORD &record);
+        quint64 (*pSortKey)(const RECORD &record);  // SORT_KEY_NUMBER; text columns sort by the display string
+    };
+
+    static void init(XModel *pModel, const COLUMN *pColumns, qint32 nNumberOfColumns)
+    {
+        for (qint32 i = 0; i < nNumberOfColumns; i++) {
+            pModel->setColumnName(i, QObject::tr(pColumns[i].pszName));
+            pModel->setColumnAlignment(i, pColumns[i].nAlignment);
+            pModel->setColumnSymbolSize(i, pColumns[i].nSymbolSize);
+
+            if (pColumns[i].sortKey != XModel::SORT_KEY_NONE) {
+                pModel->setColumnSortKey(i, pColumns[i].sortKey);
+            }
+        }
+    }
+
+    static QVariant getDisplay(const COLUMN *pColumns, qint32 nNumberOfColumns, const RECORD &record, qint32 nColumn)
+    {
+        QVariant result;
+
+        if ((nColumn >= 0) && (nColumn < nNumberOfColumns) && pColumns[nColumn].pDisplay) {
+            result = pColumns[nColumn].pDisplay(record);
+        }
+
+        return result;
+    }
+
+    static quint64 getSortKey(const COLUMN *pColumns, qint32 nNumberOfColumns, const RECORD &record, qint32 nColumn)
+    {
+        quint64 nResult = 0;
+
+        if ((nColumn >= 0) && (nColumn < nNumberOfColumns) && pColumns[nColumn].pSortKey) {
+            nResult = pColumns[nColumn].pSortKey(record);
+        }
+
+        return nResult;
+    }
+
+    static QString getText(const COLUMN *pColumns, qint32 nNumberOfColumns, const RECORD &record, qint32 nColumn)
+    {
+        return getDisplay(pColumns, nNumberOfColumns, record, nColumn).toString();
+    }
 };
 
 #endif  // XMODEL_H
@@ -1,11 +1,15 @@
 INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
+QT += concurrent
+
 HEADERS += \
-    $$PWD/xmodel.h
+    $$PWD/xmodel.h \
+    $$PWD/xbatchreader.h
 
 SOURCES += \
-    $$PWD/xmodel.cpp
+    $$PWD/xmodel.cpp \
+    $$PWD/xbatchreader.cpp
 
 DISTFILES += \
     $$PWD/LICENSE \
@@ -20,7 +20,11 @@
  */
 #include "xmodel_archiverecords.h"
 
+#include <limits>
+
 namespace {
+const qint64 N_VALUE_ABSENT = std::numeric_limits<qint64>::min();
+const qint32 N_DATE_CACHE_LIMIT = 0x1000;
 
 // Render a POSIX file mode as the familiar symbolic form plus octal, e.g.
 // "-rwxr-xr-x (0755)".  A bare decimal mode value is unreadable.
@@ -60,6 +64,119 @@ XModel_ArchiveRecords::XModel_ArchiveRecords(const QList<XBinary::FPART_PROP> &l
 
     _setColumnCount(m_listColumns.count());
     _initColumns();
+    _buildColumnData();
+}
+
+void XModel_ArchiveRecords::_buildColumnData()
+{
+    qint32 nNumberOfColumns = m_listColumns.count();
+    qint32 nNumberOfRecords = m_pListArchiveRecords ? m_pListArchiveRecords->count() : 0;
+
+    m_vecColumnData.resize(nNumberOfColumns);
+    m_nColumnDataRows = nNumberOfRecords;
+
+    for (qint32 i = 0; i < nNumberOfColumns; i++) {
+        XBinary::FPART_PROP fpartProp = m_listColumns.at(i);
+        COLUMN_DATA &columnData = m_vecColumnData[i];
+
+        if ((fpartProp == XBinary::FPART_PROP_COMPRESSEDSIZE) || (fpartProp == XBinary::FPART_PROP_UNCOMPRESSEDSIZE) ||
+            (fpartProp == XBinary::FPART_PROP_STREAMOFFSET) || (fpartProp == XBinary::FPART_PROP_STREAMSIZE)) {
+            columnData.kind = COLUMN_KIND_NUMBER;
+        } else if ((fpartProp == XBinary::FPART_PROP_UNCOMPRESSEDCRC) || (fpartProp == XBinary::FPART_PROP_RESULTCRC)) {
+            columnData.kind = COLUMN_KIND_CRC;
+        } else if ((fpartProp == XBinary::FPART_PROP_DATETIME) || (fpartProp == XBinary::FPART_PROP_MTIME) || (fpartProp == XBinary::FPART_PROP_CTIME) ||
+                   (fpartProp == XBinary::FPART_PROP_ATIME)) {
+            columnData.kind = COLUMN_KIND_DATETIME;
+        } else {
+            columnData.kind = COLUMN_KIND_STRING;
+        }
+
+        if (columnData.kind == COLUMN_KIND_STRING) {
+            columnData.vecStringOffsets.resize(nNumberOfRecords + 1);
+            columnData.vecStringOffsets[0] = 0;
+        } else {
+            columnData.vecValues.resize(nNumberOfRecords);
+        }
+
+        for (qint32 j = 0; j < nNumberOfRecords; j++) {
+            const XBinary::ARCHIVERECORD &rec = m_pListArchiveRecords->at(j);
+
+            if (columnData.kind == COLUMN_KIND_NUMBER) {
+                if (fpartProp == XBinary::FPART_PROP_STREAMOFFSET) {
+                    columnData.vecValues[j] = rec.nStreamOffset;
+                } else if (fpartProp == XBinary::FPART_PROP_STREAMSIZE) {
+                    columnData.vecValues[j] = rec.nStreamSize;
+                } else {
+                    columnData.vecValues[j] = rec.mapProperties.value(fpartProp).toLongLong();
+                }
+            } else if (columnData.kind == COLUMN_KIND_CRC) {
+                columnData.vecValues[j] = rec.mapProperties.contains(fpartProp) ? (qint64)rec.mapProperties.value(fpartProp).toULongLong() : N_VALUE_ABSENT;
+            } else if (columnData.kind == COLUMN_KIND_DATETIME) {
+                QDateTime dt = rec.mapProperties.value(fpartProp).toDateTime();
+
+                // An instant: absolute times (7z FILETIME is UTC) are shown in the local zone,
+                // local/wall-clock times (DOS/ZIP) map back to the same local time
+                columnData.vecValues[j] = dt.isValid() ? dt.toMSecsSinceEpoch() : N_VALUE_ABSENT;
+            } else {
+                QString sValue;
+
+                if ((fpartProp == XBinary::FPART_PROP_ORIGINALNAME) || (fpartProp == XBinary::FPART_PROP_OPTIONAL_PATH)) {
+                    sValue = rec.mapProperties.value(fpartProp).toString();
+                } else if (fpartProp == XBinary::FPART_PROP_HANDLEMETHOD) {
+                    sValue = XBinary::getHandleMethods(rec.mapProperties);
+                } else if (fpartProp == XBinary::FPART_PROP_FILEMODE) {
+                    if (rec.mapProperties.contains(fpartProp)) {
+                        sValue = modeToString(rec.mapProperties.value(fpartProp).toUInt(), rec.mapProperties.value(XBinary::FPART_PROP_ISFOLDER).toBool());
+                    }
+                } else if (fpartProp == XBinary::FPART_PROP_ENCRYPTED) {
+                    if (rec.mapProperties.value(fpartProp).toBool()) {
+                        sValue = QObject::tr("Yes");
+                    }
+                } else if (rec.mapProperties.contains(fpartProp)) {
+                    QVariant varValue = rec.mapProperties.value(fpartProp);
+
+                    if (varValue.userType() == QMetaType::Bool) {
+                        sValue = varValue.toBool() ? QObject::tr("Yes") : QString();
+                    } else if (varValue.userType() == QMetaType::QByteArray) {
+                        sValue = QString(varValue.toByteArray().toHex());
+                    } else if (varValue.userType() == QMetaType::QDateTime) {
+                        sValue = varValue.toDateTime().toLocalTime().toString("yyyy-MM-dd hh:mm:ss");
+                    } else {
+                        sValue = varValue.toString();
+                    }
+                }
+
+                columnData.sArena.append(sValue);
+                columnData.vecStringOffsets[j + 1] = columnData.sArena.size();
+            }
+        }
+
+        columnData.sArena.squeeze();
+
+        setColumnSortKey(i, (columnData.kind == COLUMN_KIND_STRING) ? SORT_KEY_TEXT : SORT_KEY_NUMBER);
+    }
+}
+
+QString XModel_ArchiveRecords::_getDateTimeString(qint64 nMSecs) const
+{
+    qint64 nSeconds = (nMSecs >= 0) ? (nMSecs / 1000) : ((nMSecs - 999) / 1000);  // Floor: the format has no milliseconds
+
+    QMutexLocker locker(&m_dateCacheMutex);
+
+    QHash<qint64, QString>::const_iterator iter = m_hashDateStrings.constFind(nSeconds);
+
+    if (iter != m_hashDateStrings.constEnd()) {
+        return iter.value();
+    }
+
+    if (m_hashDateStrings.count() >= N_DATE_CACHE_LIMIT) {
+        m_hashDateStrings.clear();
+    }
+
+    QString sResult = QDateTime::fromMSecsSinceEpoch(nSeconds * 1000).toString("yyyy-MM-dd hh:mm:ss");
+    m_hashDateStrings.insert(nSeconds, sResult);
+
+    return sResult;
 }
 
 void XModel_ArchiveRecords::_initColumns()
@@ -172,56 +289,24 @@ QVariant XModel_ArchiveRecords::data(const QModelIndex &index, int nRole) const
         qint32 nRow = index.row();
         if (nRow >= 0 && nRow < m_pListArchiveRecords->count()) {
             qint32 nColumn = index.column();
-            const XBinary::ARCHIVERECORD &rec = m_pListArchiveRecords->at(nRow);
+            qint32 nDataRow = _getDataRow(nRow);
+            const XBinary::ARCHIVERECORD &rec = m_pListArchiveRecords->at(nDataRow);
             if (nRole == Qt::DisplayRole) {
-                if (nColumn < m_listColumns.count()) {
-                    XBinary::FPART_PROP fpartProp = m_listColumns.at(nColumn);
-
-                    if ((fpartProp == XBinary::FPART_PROP_ORIGINALNAME) || (fpartProp == XBinary::FPART_PROP_OPTIONAL_PATH)) {
-                        result = rec.mapProperties.value(fpartProp).toString();
-                    } else if ((fpartProp == XBinary::FPART_PROP_COMPRESSEDSIZE) || (fpartProp == XBinary::FPART_PROP_UNCOMPRESSEDSIZE)) {
-                        result = rec.mapProperties.value(fpartProp).toLongLong();
-                    } else if (fpartProp == XBinary::FPART_PROP_STREAMOFFSET) {
-                        result = rec.nStreamOffset;
-                    } else if (fpartProp == XBinary::FPART_PROP_STREAMSIZE) {
-                        result = rec.nStreamSize;
-                    } else if (fpartProp == XBinary::FPART_PROP_HANDLEMETHOD) {
-                        result = XBinary::getHandleMethods(rec.mapProperties);
-                    } else if ((fpartProp == XBinary::FPART_PROP_DATETIME) || (fpartProp == XBinary::FPART_PROP_MTIME) || (fpartProp == XBinary::FPART_PROP_CTIME) ||
-                               (fpartProp == XBinary::FPART_PROP_ATIME)) {
-                        QDateTime dt = rec.mapProperties.value(fpartProp).toDateTime();
-
-                        if (dt.isValid()) {
-                            // absolute times (7z FILETIME is UTC) shown in local zone;
-                            // local/wall-clock times (DOS/ZIP) are unchanged by toLocalTime()
-                            result = dt.toLocalTime().toString("yyyy-MM-dd hh:mm:ss");
-                        }
-                    } else if ((fpartProp == XBinary::FPART_PROP_UNCOMPRESSEDCRC) || (fpartProp == XBinary::FPART_PROP_RESULTCRC)) {
-                        if (rec.mapProperties.contains(fpartProp)) {
-                            result = QString::number(rec.mapProperties.value(fpartProp).toULongLong(), 16).toUpper().rightJustified(8, QChar('0'));
-                        }
-                    } else if (fpartProp == XBinary::FPART_PROP_FILEMODE) {
-                        if (rec.mapProperties.contains(fpartProp)) {
-                            result = modeToString(rec.mapProperties.value(fpartProp).toUInt(),
-                                                  rec.mapProperties.value(XBinary::FPART_PROP_ISFOLDER).toBool());
+                if ((nColumn < m_vecColumnData.count()) && (nDataRow < m_nColumnDataRows)) {
+                    const COLUMN_DATA &columnData = m_vecColumnData.at(nColumn);
+
+                    if (columnData.kind == COLUMN_KIND_STRING) {
+                        qint32 nOffset = columnData.vecStringOffsets.at(nDataRow);
+                        result = columnData.sArena.mid(nOffset, columnData.vecStringOffsets.at(nDataRow + 1) - nOffset);
+                    } else if (columnData.kind == COLUMN_KIND_NUMBER) {
+                        result = columnData.vecValues.at(nDataRow);
+                    } else if (columnData.kind == COLUMN_KIND_CRC) {
+                        if (columnData.vecValues.at(nDataRow) != N_VALUE_ABSENT) {
+                            result = QString::number((quint64)columnData.vecValues.at(nDataRow), 16).toUpper().rightJustified(8, QChar('0'));
                         }
-                    } else if (fpartProp == XBinary::FPART_PROP_ENCRYPTED) {
-                        if (rec.mapProperties.value(fpartProp).toBool()) {
-                            result = QObject::tr("Yes");
-                        }
-                    } else {
-                        if (rec.mapProperties.contains(fpartProp)) {
-                            QVariant varValue = rec.mapProperties.value(fpartProp);
-
-                            if (varValue.userType() == QMetaType::Bool) {
-                                result = varValue.toBool() ? QObject::tr("Yes") : QString();
-                            } else if (varValue.userType() == QMetaType::QByteArray) {
-                                result = QString(varValue.toByteArray().toHex());
-                            } else if (varValue.userType() == QMetaType::QDateTime) {
-                                result = varValue.toDateTime().toLocalTime().toString("yyyy-MM-dd hh:mm:ss");
-                            } else {
-                                result = varValue.toString();
-                            }
+                    } else if (columnData.kind == COLUMN_KIND_DATETIME) {
+                        if (columnData.vecValues.at(nDataRow) != N_VALUE_ABSENT) {
+                            result = _getDateTimeString(columnData.vecValues.at(nDataRow));
                         }
                     }
                 }
@@ -260,7 +345,7 @@ QVariant XModel_ArchiveRecords::data(const QModelIndex &index, int nRole) const
                 result = getColumnAlignment(nColumn);
             } else if (nRole >= Qt::UserRole) {
                 if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
-                    result = nRow;
+                    result = nDataRow;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_OFFSET)) {
                     result = rec.nStreamOffset;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
@@ -291,3 +376,51 @@ QVariant XModel_ArchiveRecords::headerData(int nSection, Qt::Orientation orienta
 
     return result;
 }
+
+quint64 XModel_ArchiveRecords::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
+{
+    quint64 nResult = 0;
+
+    if ((nColumn >= 0) && (nColumn < m_vecColumnData.count())) {
+        const COLUMN_DATA &columnData = m_vecColumnData.at(nColumn);
+
+        if ((columnData.kind != COLUMN_KIND_STRING) && (nDataRow >= 0) && (nDataRow < columnData.vecValues.count())) {
+            if (columnData.kind == COLUMN_KIND_CRC) {
+                nResult = (columnData.vecValues.at(nDataRow) == N_VALUE_ABSENT) ? 0 : ((quint64)columnData.vecValues.at(nDataRow) + 1);
+            } else {
+                nResult = getSignedSortKey(columnData.vecValues.at(nDataRow));  // Absent dates first
+            }
+        }
+    }
+
+    return nResult;
+}
+
+QString XModel_ArchiveRecords::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
+{
+    QString sResult;
+
+    if ((nColumn >= 0) && (nColumn < m_vecColumnData.count()) && (nDataRow >= 0) && (nDataRow < m_nColumnDataRows)) {
+        const COLUMN_DATA &columnData = m_vecColumnData.at(nColumn);
+
+        if (columnData.kind == COLUMN_KIND_STRING) {
+            qint32 nOffset = columnData.vecStringOffsets.at(nDataRow);
+            sResult = columnData.sArena.mid(nOffset, columnData.vecStringOffsets.at(nDataRow + 1) - nOffset);
+        }
+    }
+
+    return sResult;
+}
+
+qint64 XModel_ArchiveRecords::getResidentSize() const
+{
+    qint64 nResult = XModel::getResidentSize();
+
+    for (qint32 i = 0; i < m_vecColumnData.count(); i++) {
+        const COLUMN_DATA &columnData = m_vecColumnData.at(i);
+        nResult += columnData.vecValues.size() * (qint64)sizeof(qint64) + columnData.vecStringOffsets.size() * (qint64)sizeof(qint32) +
+                   columnData.sArena.size() * (qint64)sizeof(QChar);
+    }
+
+    return nResult;
+}
@@ -21,6 +21,8 @@
 #ifndef XMODEL_ARCHIVERECORDS_H
 #define XMODEL_ARCHIVERECORDS_H
 
+#include <QMutex>
+
 #include "xbinary.h"
 #include "xmodel.h"
 
@@ -32,11 +34,37 @@ public:
 
     QVariant data(const QModelIndex &index, int nRole = Qt::DisplayRole) const override;
     QVariant headerData(int nSection, Qt::Orientation orientation, int nRole = Qt::DisplayRole) const override;
+    virtual qint64 getResidentSize() const override;
+
+protected:
+    virtual quint64 _getSortColumnKey(qint32 nDataRow, qint32 nColumn) const override;
+    virtual QString _getSortColumnText(qint32 nDataRow, qint32 nColumn) const override;
 
 private:
+    enum COLUMN_KIND {
+        COLUMN_KIND_STRING = 0,  // Display strings, formatted once into the column arena
+        COLUMN_KIND_NUMBER,
+        COLUMN_KIND_CRC,
+        COLUMN_KIND_DATETIME     // Milliseconds since epoch; the strings are formatted on demand
+    };
+
+    // Columnar snapshot of the records: built once, data() and the sort keys read flat arrays
+    struct COLUMN_DATA {
+        COLUMN_KIND kind;
+        QVector<qint64> vecValues;         // Number, CRC and date columns
+        QVector<qint32> vecStringOffsets;  // String columns: nRows + 1 offsets into sArena
+        QString sArena;
+    };
+
     QList<XBinary::ARCHIVERECORD> *m_pListArchiveRecords;
     void _initColumns();
+    void _buildColumnData();
+    QString _getDateTimeString(qint64 nMSecs) const;
     QList<XBinary::FPART_PROP> m_listColumns;
+    QVector<COLUMN_DATA> m_vecColumnData;
+    qint32 m_nColumnDataRows;
+    mutable QMutex m_dateCacheMutex;
+    mutable QHash<qint64, QString> m_hashDateStrings;  // By second; archive entries share timestamps
 };
 
 #endif  // XMODEL_ARCHIVERECORDS_H
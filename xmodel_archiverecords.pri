@@ -1,11 +1,15 @@
 INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
+QT += concurrent
+
 HEADERS += \
-    $$PWD/xmodel_archiverecords.h
+    $$PWD/xmodel_archiverecords.h \
+    $$PWD/xmodel_archivetree.h
 
 SOURCES += \
-    $$PWD/xmodel_archiverecords.cpp
+    $$PWD/xmodel_archiverecords.cpp \
+    $$PWD/xmodel_archivetree.cpp
 
 DISTFILES += \
     $$PWD/LICENSE \
@@ -0,0 +1,511 @@
+/* Copyright (c) 2025-2026 hors<horsicq@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "xmodel_archivetree.h"
+
+#include <algorithm>
+#include <QThread>
+#include <QtConcurrent>
+
+namespace {
+const qint32 N_FETCH_BATCH = 0x400;                 // Rows per fetchMore()
+const qint32 N_PARALLEL_THRESHOLD = 0x4000;         // Records; smaller archives are built on one thread
+
+bool _isSeparator(QChar cChar)
+{
+    return (cChar == QChar('/')) || (cChar == QChar('\\'));
+}
+}  // namespace
+
+// Builds the trie of one chunk of records with the totals of every folder; merged by _build()
+struct XArchiveTreeChunk {
+    typedef void result_type;
+
+    const QList<XBinary::ARCHIVERECORD> *pListRecords;
+    QVector<QVector<XModel_ArchiveTree::NODE>> *pVecChunkNodes;
+    qint32 nChunkSize;
+    qint32 nCount;
+
+    void operator()(qint32 nChunk) const
+    {
+        QVector<XModel_ArchiveTree::NODE> &vecNodes = (*pVecChunkNodes)[nChunk];
+        QHash<QPair<qint32, QString>, qint32> hashFolders;
+        QVector<QString> vecParts;
+
+        XModel_ArchiveTree::NODE nodeRoot = {};
+        nodeRoot.nParent = -1;
+        nodeRoot.nRecord = -1;
+        nodeRoot.bIsFolder = true;
+        vecNodes.append(nodeRoot);
+
+        qint32 nStart = nChunk * nChunkSize;
+        qint32 nEnd = qMin(nStart + nChunkSize, nCount);
+
+        for (qint32 i = nStart; i < nEnd; i++) {
+            const XBinary::ARCHIVERECORD &rec = pListRecords->at(i);
+            QString sPath = XModel_ArchiveTree::getRecordPath(rec);
+            bool bIsFolder = rec.mapProperties.value(XBinary::FPART_PROP_ISFOLDER).toBool();
+            qint64 nSize = rec.mapProperties.value(XBinary::FPART_PROP_UNCOMPRESSEDSIZE).toLongLong();
+            qint64 nCompressedSize = rec.mapProperties.value(XBinary::FPART_PROP_COMPRESSEDSIZE).toLongLong();
+
+            vecParts.clear();
+
+            qint32 nLength = sPath.length();
+            qint32 nPartStart = 0;
+
+            for (qint32 j = 0; j <= nLength; j++) {
+                if ((j == nLength) || _isSeparator(sPath.at(j))) {
+                    if ((j > nPartStart) && !((j - nPartStart == 1) && (sPath.at(nPartStart) == QChar('.')))) {
+                        vecParts.append(sPath.mid(nPartStart, j - nPartStart));
+                    }
+
+                    nPartStart = j + 1;
+                }
+            }
+
+            if ((nLength > 0) && _isSeparator(sPath.at(nLength - 1))) {
+                bIsFolder = true;
+            }
+
+            if (vecParts.isEmpty()) {
+                vecParts.append(QString("#%1").arg(i));
+            }
+
+            qint32 nNumberOfParts = vecParts.count();
+            qint32 nCurrent = 0;
+
+            for (qint32 j = 0; j < nNumberOfParts; j++) {
+                if (!bIsFolder) {
+                    vecNodes[nCurrent].nSize += nSize;
+                    vecNodes[nCurrent].nCompressedSize += nCompressedSize;
+                    vecNodes[nCurrent].nNumberOfFiles++;
+                }
+
+                bool bLast = (j == (nNumberOfParts - 1));
+
+                if (bLast && !bIsFolder) {
+                    XModel_ArchiveTree::NODE node = {};
+                    node.sName = vecParts.at(j);
+                    node.nParent = nCurrent;
+                    node.nRecord = i;
+                    node.nSize = nSize;
+                    node.nCompressedSize = nCompressedSize;
+                    vecNodes.append(node);
+                } else {
+                    QPair<qint32, QString> key(nCurrent, vecParts.at(j));
+                    qint32 nFolder = hashFolders.value(key, -1);
+
+                    if (nFolder == -1) {
+                        XModel_ArchiveTree::NODE node = {};
+                        node.sName = vecParts.at(j);
+                        node.nParent = nCurrent;
+                        node.nRecord = -1;
+                        node.bIsFolder = true;
+
+                        nFolder = vecNodes.count();
+                        vecNodes.append(node);
+                        hashFolders.insert(key, nFolder);
+                    }
+
+                    if (bLast) {
+                        vecNodes[nFolder].nRecord = i;
+                    }
+
+                    nCurrent = nFolder;
+                }
+            }
+        }
+    }
+};
+
+// Folders first, then by name; equal names keep the archive order
+struct XArchiveTreeChildLess {
+    const QVector<XModel_ArchiveTree::NODE> *pVecNodes;
+
+    bool operator()(qint32 nNode1, qint32 nNode2) const
+    {
+        const XModel_ArchiveTree::NODE &node1 = pVecNodes->at(nNode1);
+        const XModel_ArchiveTree::NODE &node2 = pVecNodes->at(nNode2);
+
+        if (node1.bIsFolder != node2.bIsFolder) {
+            return node1.bIsFolder;
+        }
+
+        qint32 nCompare = QString::compare(node1.sName, node2.sName, Qt::CaseInsensitive);
+
+        if (nCompare != 0) {
+            return nCompare < 0;
+        }
+
+        return nNode1 < nNode2;
+    }
+};
+
+XModel_ArchiveTree::XModel_ArchiveTree(QList<XBinary::ARCHIVERECORD> *pListArchiveRecords, QObject *pParent) : QAbstractItemModel(pParent)
+{
+    m_pListArchiveRecords = pListArchiveRecords;
+
+    _build();
+}
+
+QString XModel_ArchiveTree::getRecordPath(const XBinary::ARCHIVERECORD &record)
+{
+    QString sResult = record.mapProperties.value(XBinary::FPART_PROP_OPTIONAL_PATH).toString();
+    QString sName = record.mapProperties.value(XBinary::FPART_PROP_ORIGINALNAME).toString();
+
+    if (sResult.isEmpty()) {
+        sResult = sName;
+    } else if (!sName.isEmpty() && (sResult != sName)) {
+        qint32 nNameOffset = sResult.length() - sName.length();
+        bool bContainsName = (nNameOffset > 0) && sResult.endsWith(sName) && _isSeparator(sResult.at(nNameOffset - 1));
+
+        if (!bContainsName) {
+            sResult += QChar('/') + sName;  // The path is the directory of the entry
+        }
+    }
+
+    return sResult;
+}
+
+void XModel_ArchiveTree::_build()
+{
+    qint32 nCount = m_pListArchiveRecords ? m_pListArchiveRecords->count() : 0;
+    qint32 nNumberOfChunks = 1;
+
+    if (nCount >= N_PARALLEL_THRESHOLD) {
+        nNumberOfChunks = qMax(1, QThread::idealThreadCount());
+    }
+
+    qint32 nChunkSize = (nCount + nNumberOfChunks - 1) / nNumberOfChunks;
+    QVector<qint32> vecChunks(nNumberOfChunks);
+
+    for (qint32 i = 0; i < nNumberOfChunks; i++) {
+        vecChunks[i] = i;
+    }
+
+    QVector<QVector<NODE>> vecChunkNodes(nNumberOfChunks);
+
+    XArchiveTreeChunk functorChunk;
+    functorChunk.pListRecords = m_pListArchiveRecords;
+    functorChunk.pVecChunkNodes = &vecChunkNodes;
+    functorChunk.nChunkSize = nChunkSize;
+    functorChunk.nCount = nCount;
+
+    if (nNumberOfChunks > 1) {
+        QtConcurrent::blockingMap(vecChunks, functorChunk);
+    } else {
+        functorChunk(0);
+    }
+
+    // Merge the chunk tries: the nodes of a chunk come after their parents, folders are unified by (parent, name)
+    NODE nodeRoot = {};
+    nodeRoot.nParent = -1;
+    nodeRoot.nRecord = -1;
+    nodeRoot.bIsFolder = true;
+
+    m_vecNodes.clear();
+    m_vecNodes.append(nodeRoot);
+
+    QHash<QPair<qint32, QString>, qint32> hashFolders;
+    QVector<qint32> vecMap;
+
+    for (qint32 i = 0; i < nNumberOfChunks; i++) {
+        QVector<NODE> &vecNodes = vecChunkNodes[i];
+        qint32 nNumberOfNodes = vecNodes.count();
+
+        vecMap.resize(nNumberOfNodes);
+        vecMap[0] = 0;
+
+        m_vecNodes[0].nSize += vecNodes.at(0).nSize;
+        m_vecNodes[0].nCompressedSize += vecNodes.at(0).nCompressedSize;
+        m_vecNodes[0].nNumberOfFiles += vecNodes.at(0).nNumberOfFiles;
+
+        for (qint32 j = 1; j < nNumberOfNodes; j++) {
+            const NODE &node = vecNodes.at(j);
+            qint32 nParent = vecMap.at(node.nParent);
+            qint32 nNode = -1;
+
+            if (node.bIsFolder) {
+                nNode = hashFolders.value(QPair<qint32, QString>(nParent, node.sName), -1);
+            }
+
+            if (nNode == -1) {
+                nNode = m_vecNodes.count();
+                m_vecNodes.append(node);
+                m_vecNodes[nNode].nParent = nParent;
+
+                if (node.bIsFolder) {
+                    hashFolders.insert(QPair<qint32, QString>(nParent, node.sName), nNode);
+                }
+            } else {
+                NODE &nodeFolder = m_vecNodes[nNode];
+                nodeFolder.nSize += node.nSize;
+                nodeFolder.nCompressedSize += node.nCompressedSize;
+                nodeFolder.nNumberOfFiles += node.nNumberOfFiles;
+
+                if (nodeFolder.nRecord == -1) {
+                    nodeFolder.nRecord = node.nRecord;
+                }
+            }
+
+            vecMap[j] = nNode;
+        }
+
+        vecNodes.clear();
+        vecNodes.squeeze();
+    }
+
+    // Children lists, contiguous per node
+    qint32 nNumberOfNodes = m_vecNodes.count();
+
+    for (qint32 i = 1; i < nNumberOfNodes; i++) {
+        m_vecNodes[m_vecNodes.at(i).nParent].nNumberOfChildren++;
+    }
+
+    qint32 nPosition = 0;
+
+    for (qint32 i = 0; i < nNumberOfNodes; i++) {
+        m_vecNodes[i].nFirstChild = nPosition;
+        nPosition += m_vecNodes.at(i).nNumberOfChildren;
+        m_vecNodes[i].nNumberOfChildren = 0;
+    }
+
+    m_vecChildren.resize(nPosition);
+
+    for (qint32 i = 1; i < nNumberOfNodes; i++) {
+        NODE &nodeParent = m_vecNodes[m_vecNodes.at(i).nParent];
+        m_vecChildren[nodeParent.nFirstChild + nodeParent.nNumberOfChildren] = i;
+        nodeParent.nNumberOfChildren++;
+    }
+
+    m_vecNodes.squeeze();
+}
+
+void XModel_ArchiveTree::_sortChildren(qint32 nNode)
+{
+    NODE &node = m_vecNodes[nNode];
+
+    if (!node.bSorted) {
+        qint32 *pChildren = m_vecChildren.data() + node.nFirstChild;
+
+        XArchiveTreeChildLess functorLess;
+        functorLess.pVecNodes = &m_vecNodes;
+
+        std::sort(pChildren, pChildren + node.nNumberOfChildren, functorLess);
+
+        for (qint32 i = 0; i < node.nNumberOfChildren; i++) {
+            m_vecNodes[pChildren[i]].nRow = i;
+        }
+
+        node.bSorted = true;
+    }
+}
+
+qint32 XModel_ArchiveTree::_getNode(const QModelIndex &index) const
+{
+    return index.isValid() ? (qint32)index.internalId() : 0;
+}
+
+QModelIndex XModel_ArchiveTree::index(int nRow, int nColumn, const QModelIndex &parent) const
+{
+    QModelIndex result;
+
+    if (hasIndex(nRow, nColumn, parent)) {
+        const NODE &nodeParent = m_vecNodes.at(_getNode(parent));
+        result = createIndex(nRow, nColumn, (quintptr)m_vecChildren.at(nodeParent.nFirstChild + nRow));
+    }
+
+    return result;
+}
+
+QModelIndex XModel_ArchiveTree::parent(const QModelIndex &child) const
+{
+    QModelIndex result;
+
+    if (child.isValid()) {
+        qint32 nParent = m_vecNodes.at(_getNode(child)).nParent;
+
+        if (nParent > 0) {
+            result = createIndex(m_vecNodes.at(nParent).nRow, 0, (quintptr)nParent);
+        }
+    }
+
+    return result;
+}
+
+int XModel_ArchiveTree::rowCount(const QModelIndex &parent) const
+{
+    int nResult = 0;
+
+    if (parent.column() <= 0) {
+        nResult = m_vecNodes.at(_getNode(parent)).nFetched;
+    }
+
+    return nResult;
+}
+
+int XModel_ArchiveTree::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+
+    return __COLUMN_COUNT;
+}
+
+bool XModel_ArchiveTree::hasChildren(const QModelIndex &parent) const
+{
+    bool bResult = false;
+
+    if (parent.column() <= 0) {
+        bResult = (m_vecNodes.at(_getNode(parent)).nNumberOfChildren > 0);
+    }
+
+    return bResult;
+}
+
+bool XModel_ArchiveTree::canFetchMore(const QModelIndex &parent) const
+{
+    bool bResult = false;
+
+    if (parent.column() <= 0) {
+        const NODE &node = m_vecNodes.at(_getNode(parent));
+        bResult = (node.nFetched < node.nNumberOfChildren);
+    }
+
+    return bResult;
+}
+
+void XModel_ArchiveTree::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent)) {
+        qint32 nNode = _getNode(parent);
+
+        _sortChildren(nNode);
+
+        qint32 nFetched = m_vecNodes.at(nNode).nFetched;
+        qint32 nBatch = qMin(N_FETCH_BATCH, m_vecNodes.at(nNode).nNumberOfChildren - nFetched);
+
+        beginInsertRows(parent, nFetched, nFetched + nBatch - 1);
+        m_vecNodes[nNode].nFetched = nFetched + nBatch;
+        endInsertRows();
+    }
+}
+
+QVariant XModel_ArchiveTree::data(const QModelIndex &index, int nRole) const
+{
+    QVariant result;
+
+    if (index.isValid()) {
+        const NODE &node = m_vecNodes.at(_getNode(index));
+        qint32 nColumn = index.column();
+
+        if (nRole == Qt::DisplayRole) {
+            if (nColumn == COLUMN_NAME) {
+                result = node.sName;
+            } else if (nColumn == COLUMN_SIZE) {
+                result = node.nSize;
+            } else if (nColumn == COLUMN_COMPRESSEDSIZE) {
+                result = node.nCompressedSize;
+            } else if (nColumn == COLUMN_ENTRIES) {
+                if (node.bIsFolder) {
+                    result = node.nNumberOfFiles;
+                }
+            }
+        } else if (nRole == Qt::TextAlignmentRole) {
+            if (nColumn == COLUMN_NAME) {
+                result = (qint32)(Qt::AlignVCenter | Qt::AlignLeft);
+            } else {
+                result = (qint32)(Qt::AlignVCenter | Qt::AlignRight);
+            }
+        } else if (nRole >= Qt::UserRole) {
+            if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
+                result = node.nRecord;
+            } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
+                result = node.nSize;
+            } else if (nRole == (Qt::UserRole + XModel::USERROLE_STRING1)) {
+                result = getPath(index);
+            }
+        }
+    }
+
+    return result;
+}
+
+QVariant XModel_ArchiveTree::headerData(int nSection, Qt::Orientation orientation, int nRole) const
+{
+    QVariant result;
+
+    if (orientation == Qt::Horizontal) {
+        if (nRole == Qt::DisplayRole) {
+            if (nSection == COLUMN_NAME) {
+                result = QObject::tr("Name");
+            } else if (nSection == COLUMN_SIZE) {
+                result = QObject::tr("Size");
+            } else if (nSection == COLUMN_COMPRESSEDSIZE) {
+                result = QObject::tr("Compressed size");
+            } else if (nSection == COLUMN_ENTRIES) {
+                result = QObject::tr("Entries");
+            }
+        } else if (nRole == Qt::TextAlignmentRole) {
+            if (nSection == COLUMN_NAME) {
+                result = (qint32)(Qt::AlignVCenter | Qt::AlignLeft);
+            } else {
+                result = (qint32)(Qt::AlignVCenter | Qt::AlignRight);
+            }
+        }
+    }
+
+    return result;
+}
+
+qint32 XModel_ArchiveTree::getRecordIndex(const QModelIndex &index) const
+{
+    qint32 nResult = -1;
+
+    if (index.isValid()) {
+        nResult = m_vecNodes.at(_getNode(index)).nRecord;
+    }
+
+    return nResult;
+}
+
+QString XModel_ArchiveTree::getPath(const QModelIndex &index) const
+{
+    QString sResult;
+    qint32 nNode = _getNode(index);
+
+    while (nNode > 0) {
+        const NODE &node = m_vecNodes.at(nNode);
+
+        if (sResult.isEmpty()) {
+            sResult = node.sName;
+        } else {
+            sResult = node.sName + QChar('/') + sResult;
+        }
+
+        nNode = node.nParent;
+    }
+
+    return sResult;
+}
+
+bool XModel_ArchiveTree::isFolder(const QModelIndex &index) const
+{
+    return m_vecNodes.at(_getNode(index)).bIsFolder;
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2025-2026 hors<horsicq@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef XMODEL_ARCHIVETREE_H
+#define XMODEL_ARCHIVETREE_H
+
+#include <QAbstractItemModel>
+
+#include "xbinary.h"
+#include "xmodel.h"
+
+// Directory tree over the archive records of XModel_ArchiveRecords. The path trie is built once, in
+// parallel chunks; the children of a directory are sorted and handed to the view in batches by fetchMore().
+class XModel_ArchiveTree : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    enum COLUMN {
+        COLUMN_NAME = 0,
+        COLUMN_SIZE,
+        COLUMN_COMPRESSEDSIZE,
+        COLUMN_ENTRIES,
+        __COLUMN_COUNT
+    };
+
+    explicit XModel_ArchiveTree(QList<XBinary::ARCHIVERECORD> *pListArchiveRecords, QObject *pParent = nullptr);
+
+    virtual QModelIndex index(int nRow, int nColumn, const QModelIndex &parent = QModelIndex()) const override;
+    virtual QModelIndex parent(const QModelIndex &child) const override;
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    virtual bool canFetchMore(const QModelIndex &parent) const override;
+    virtual void fetchMore(const QModelIndex &parent) override;
+    virtual QVariant data(const QModelIndex &index, int nRole = Qt::DisplayRole) const override;
+    virtual QVariant headerData(int nSection, Qt::Orientation orientation, int nRole = Qt::DisplayRole) const override;
+
+    qint32 getRecordIndex(const QModelIndex &index) const;  // -1: directory without an own record
+    QString getPath(const QModelIndex &index) const;
+    bool isFolder(const QModelIndex &index) const;
+
+    static QString getRecordPath(const XBinary::ARCHIVERECORD &record);
+
+private:
+    struct NODE {
+        QString sName;
+        qint32 nParent;
+        qint32 nRecord;
+        qint32 nFirstChild;  // Into m_vecChildren
+        qint32 nNumberOfChildren;
+        qint32 nFetched;  // Children already shown by the view
+        qint32 nRow;      // Row in the parent, valid once the parent is sorted
+        bool bIsFolder;
+        bool bSorted;
+        // Totals of the subtree; a file has its own sizes
+        qint64 nSize;
+        qint64 nCompressedSize;
+        qint32 nNumberOfFiles;
+    };
+
+    friend struct XArchiveTreeChunk;
+    friend struct XArchiveTreeChildLess;
+
+    void _build();
+    void _sortChildren(qint32 nNode);
+    qint32 _getNode(const QModelIndex &index) const;
+
+    QList<XBinary::ARCHIVERECORD> *m_pListArchiveRecords;
+    QVector<NODE> m_vecNodes;         // 0: root
+    QVector<qint32> m_vecChildren;    // Children of all nodes, contiguous per node
+};
+
+#endif  // XMODEL_ARCHIVETREE_H
@@ -20,6 +20,67 @@
  */
 #include "xmodel_fparts.h"
 
+namespace {
+QVariant _getName(const XBinary::FPART &record)
+{
+    return record.sName;
+}
+
+QVariant _getOffset(const XBinary::FPART &record)
+{
+    return QString::number(record.nFileOffset, 16);
+}
+
+quint64 _getOffsetKey(const XBinary::FPART &record)
+{
+    return XModel::getSignedSortKey(record.nFileOffset);
+}
+
+QVariant _getSize(const XBinary::FPART &record)
+{
+    return QString::number(record.nFileSize, 16);
+}
+
+quint64 _getSizeKey(const XBinary::FPART &record)
+{
+    return XModel::getSignedSortKey(record.nFileSize);
+}
+
+QVariant _getVirtualAddress(const XBinary::FPART &record)
+{
+    return (record.nVirtualAddress != (XADDR)-1) ? QVariant(QString::number(record.nVirtualAddress, 16)) : QVariant();
+}
+
+quint64 _getVirtualAddressKey(const XBinary::FPART &record)
+{
+    return (record.nVirtualAddress != (XADDR)-1) ? ((quint64)record.nVirtualAddress + 1) : 0;  // No address: empty cells first
+}
+
+QVariant _getVirtualSize(const XBinary::FPART &record)
+{
+    return (record.nVirtualAddress != (XADDR)-1) ? QVariant(QString::number(record.nVirtualSize, 16)) : QVariant();
+}
+
+quint64 _getVirtualSizeKey(const XBinary::FPART &record)
+{
+    return (record.nVirtualAddress != (XADDR)-1) ? ((quint64)record.nVirtualSize + 1) : 0;
+}
+
+QVariant _getPart(const XBinary::FPART &record)
+{
+    return XBinary::recordFilePartIdToString(record.filePart);
+}
+
+const XModelColumns<XBinary::FPART>::COLUMN g_columns[XModel_FPARTS::__COLUMN_COUNT] = {
+    {QT_TRANSLATE_NOOP("QObject", "Name"), Qt::AlignVCenter | Qt::AlignLeft, 20, XModel::SORT_KEY_TEXT, _getName, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Offset"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getOffset, _getOffsetKey},
+    {QT_TRANSLATE_NOOP("QObject", "Size"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getSize, _getSizeKey},
+    {QT_TRANSLATE_NOOP("QObject", "Address"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getVirtualAddress, _getVirtualAddressKey},
+    {QT_TRANSLATE_NOOP("QObject", "V.Size"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getVirtualSize, _getVirtualSizeKey},
+    {QT_TRANSLATE_NOOP("QObject", "Part"), Qt::AlignVCenter | Qt::AlignLeft, 12, XModel::SORT_KEY_TEXT, _getPart, nullptr},
+};
+}  // namespace
+
 XModel_FPARTS::XModel_FPARTS(QList<XBinary::FPART> *pListFParts, QObject *pParent) : XModel(pParent)
 {
     m_pListFParts = pListFParts;
@@ -34,26 +95,7 @@ XModel_FPARTS::XModel_FPARTS(QList<XBinary::FPART> *pListFParts, QObject *pParen
 
 void XModel_FPARTS::_initColumns()
 {
-    setColumnName(COLUMN_NAME, QObject::tr("Name"));
-    setColumnName(COLUMN_OFFSET, QObject::tr("Offset"));
-    setColumnName(COLUMN_SIZE, QObject::tr("Size"));
-    setColumnName(COLUMN_VADDRESS, QObject::tr("Address"));
-    setColumnName(COLUMN_VSIZE, QObject::tr("V.Size"));
-    setColumnName(COLUMN_PART, QObject::tr("Part"));
-
-    setColumnAlignment(COLUMN_NAME, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_OFFSET, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_SIZE, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_VADDRESS, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_VSIZE, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_PART, Qt::AlignVCenter | Qt::AlignLeft);
-
-    setColumnSymbolSize(COLUMN_NAME, 20);
-    setColumnSymbolSize(COLUMN_OFFSET, 16);
-    setColumnSymbolSize(COLUMN_SIZE, 16);
-    setColumnSymbolSize(COLUMN_VADDRESS, 16);
-    setColumnSymbolSize(COLUMN_VSIZE, 16);
-    setColumnSymbolSize(COLUMN_PART, 12);
+    XModelColumns<XBinary::FPART>::init(this, g_columns, __COLUMN_COUNT);
 }
 
 QVariant XModel_FPARTS::data(const QModelIndex &index, int nRole) const
@@ -68,31 +110,16 @@ QVariant XModel_FPARTS::data(const QModelIndex &index, int nRole) const
         qint32 nRow = index.row();
         if (nRow >= 0 && nRow < m_pListFParts->count()) {
             qint32 nColumn = index.column();
-            const XBinary::FPART &rec = m_pListFParts->at(nRow);
+            qint32 nDataRow = _getDataRow(nRow);
+            const XBinary::FPART &rec = m_pListFParts->at(nDataRow);
             if (nRole == Qt::DisplayRole) {
-                if (nColumn == COLUMN_NAME) {
-                    result = rec.sName;
-                } else if (nColumn == COLUMN_OFFSET) {
-                    result = QString::number(rec.nFileOffset, 16);
-                } else if (nColumn == COLUMN_SIZE) {
-                    result = QString::number(rec.nFileSize, 16);
-                } else if (nColumn == COLUMN_VADDRESS) {
-                    if (rec.nVirtualAddress != (XADDR)-1) {
-                        result = QString::number(rec.nVirtualAddress, 16);
-                    }
-                } else if (nColumn == COLUMN_VSIZE) {
-                    if (rec.nVirtualAddress != (XADDR)-1) {
-                        result = QString::number(rec.nVirtualSize, 16);
-                    }
-                } else if (nColumn == COLUMN_PART) {
-                    result = XBinary::recordFilePartIdToString(rec.filePart);
-                }
+                result = XModelColumns<XBinary::FPART>::getDisplay(g_columns, __COLUMN_COUNT, rec, nColumn);
             } else if (nRole == Qt::TextAlignmentRole) {
                 result = getColumnAlignment(nColumn);
             } else if (nRole >= Qt::UserRole) {
                 // Expose some raw values for sorting/filtering
                 if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
-                    result = nRow;
+                    result = nDataRow;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_OFFSET)) {
                     result = rec.nFileOffset;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
@@ -126,23 +153,17 @@ QVariant XModel_FPARTS::headerData(int nSection, Qt::Orientation orientation, in
     return result;
 }
 
-XModel::SORT_METHOD XModel_FPARTS::getSortMethod(qint32 nColumn)
+bool XModel_FPARTS::isCustomFilter()
 {
-    SORT_METHOD result = SORT_METHOD_DEFAULT;
-
-    if ((nColumn == COLUMN_OFFSET) || (nColumn == COLUMN_SIZE) || (nColumn == COLUMN_VADDRESS) || (nColumn == COLUMN_VSIZE)) {
-        result = SORT_METHOD_HEX;
-    }
-
-    return result;
+    return false;
 }
 
-bool XModel_FPARTS::isCustomFilter()
+quint64 XModel_FPARTS::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::FPART>::getSortKey(g_columns, __COLUMN_COUNT, m_pListFParts->at(nDataRow), nColumn);
 }
 
-bool XModel_FPARTS::isCustomSort()
+QString XModel_FPARTS::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::FPART>::getText(g_columns, __COLUMN_COUNT, m_pListFParts->at(nDataRow), nColumn);
 }
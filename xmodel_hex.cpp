@@ -22,9 +22,41 @@
 
 #include <QtGlobal>
 
+namespace {
+const qint64 N_HEX_PAGE_SIZE = 0x10000;
+const qint32 N_HEX_PAGES = 8;
+
+struct XHEX_TABLES {
+    ushort hex[256][2];
+    ushort ascii[256];
+
+    XHEX_TABLES()
+    {
+        const char *pszDigits = "0123456789abcdef";
+
+        for (qint32 i = 0; i < 256; i++) {
+            hex[i][0] = (ushort)pszDigits[i >> 4];
+            hex[i][1] = (ushort)pszDigits[i & 0x0F];
+            ascii[i] = ((i >= 0x20) && (i <= 0x7E)) ? (ushort)i : (ushort)'.';
+        }
+    }
+};
+
+const XHEX_TABLES &_getHexTables()
+{
+    static const XHEX_TABLES tables;  // Thread-safe initialization
+
+    return tables;
+}
+}  // namespace
+
 XModel_Hex::XModel_Hex(QIODevice *pDevice, qint64 nOffset, qint64 nSize, quint64 nStartAddress, qint32 nBytesPerLine, QObject *pParent)
     : XModel(pParent), m_pDevice(pDevice), m_nOffset(nOffset), m_nSize(nSize), m_nStartAddress(nStartAddress), m_nBytesPerLine(nBytesPerLine)
 {
+    m_nFormattedRow = -1;
+    m_nGroupSize = 1;
+    m_groupEndian = XBinary::ENDIAN_LITTLE;
+
     if (!m_pDevice) {
         _setRowCount(0);
         _setColumnCount(0);
@@ -38,8 +70,7 @@ XModel_Hex::XModel_Hex(QIODevice *pDevice, qint64 nOffset, qint64 nSize, quint64
 
     if (m_nBytesPerLine <= 0) m_nBytesPerLine = 16;
 
-    qint32 rows = (qint32)((m_nSize + m_nBytesPerLine - 1) / m_nBytesPerLine);
-    _setRowCount(rows);
+    _setRowCount(_getRowCount(m_nBytesPerLine));
     _setColumnCount(__COLUMN_COUNT);
 
     setColumnName(COLUMN_ADDRESS, QObject::tr("Address"));
@@ -61,22 +92,17 @@ QVariant XModel_Hex::data(const QModelIndex &index, int nRole) const
     int column = index.column();
 
     if (nRole == Qt::DisplayRole) {
-        qint64 lineOffset = m_nOffset + (qint64)row * m_nBytesPerLine;
-        int bytesThisLine = (int)qMin<qint64>(m_nBytesPerLine, m_nSize - (row * (qint64)m_nBytesPerLine));
-        if (bytesThisLine < 0) bytesThisLine = 0;
-
         if (!m_pDevice->isSequential()) {
-            qint64 prev = m_pDevice->pos();
-            m_pDevice->seek(lineOffset);
-            QByteArray chunk = m_pDevice->read(bytesThisLine);
-            m_pDevice->seek(prev);
-
             if (column == COLUMN_ADDRESS) {
-                result = QString::number((qulonglong)(m_nStartAddress + (quint64)(row * m_nBytesPerLine)), 16).rightJustified(8, '0');
-            } else if (column == COLUMN_HEX) {
-                result = _bytesToHex(chunk);
-            } else if (column == COLUMN_ASCII) {
-                result = _bytesToAscii(chunk);
+                result = QString::number((qulonglong)(m_nStartAddress + (quint64)row * m_nBytesPerLine), 16).rightJustified(8, '0');
+            } else if ((column == COLUMN_HEX) || (column == COLUMN_ASCII)) {
+                QMutexLocker locker(&m_cacheMutex);
+
+                if (m_nFormattedRow != row) {
+                    _formatRow(row);
+                }
+
+                result = (column == COLUMN_HEX) ? m_sFormattedHex : m_sFormattedAscii;
             }
         }
     } else if (nRole == Qt::TextAlignmentRole) {
@@ -101,26 +127,237 @@ QVariant XModel_Hex::headerData(int nSection, Qt::Orientation orientation, int n
     return result;
 }
 
-QString XModel_Hex::_bytesToHex(const QByteArray &ba) const
+qint32 XModel_Hex::_getColumnSymbolHint(qint32 nColumn) const
 {
-    QString s;
-    s.reserve(ba.size() * 3);
-    for (int i = 0; i < ba.size(); ++i) {
-        unsigned char c = (unsigned char)ba.at(i);
-        s.append(QString::number(c, 16).rightJustified(2, '0'));
-        if (i + 1 < ba.size()) s.append(' ');
+    qint32 nResult = -1;
+    qint32 nLineSize = (qint32)qMin((qint64)m_nBytesPerLine, m_nSize);
+
+    if (nColumn == COLUMN_ADDRESS) {
+        quint64 nLastAddress = m_nStartAddress + (quint64)qMax(rowCount() - 1, 0) * m_nBytesPerLine;
+        nResult = qMax(8, QString::number((qulonglong)nLastAddress, 16).length());
+    } else if (nColumn == COLUMN_HEX) {
+        nResult = nLineSize ? (nLineSize * 2 + (nLineSize + m_nGroupSize - 1) / m_nGroupSize - 1) : 0;
+    } else if (nColumn == COLUMN_ASCII) {
+        nResult = nLineSize;
+    }
+
+    return nResult;
+}
+
+void XModel_Hex::setBytesPerLine(qint32 nBytesPerLine)
+{
+    if (nBytesPerLine <= 0) nBytesPerLine = 16;
+
+    nBytesPerLine = ((nBytesPerLine + m_nGroupSize - 1) / m_nGroupSize) * m_nGroupSize;  // Whole words per line
+
+    if ((!m_pDevice) || (nBytesPerLine == m_nBytesPerLine)) {
+        m_nBytesPerLine = nBytesPerLine;
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+
+    QModelIndexList listFrom = persistentIndexList();
+    QModelIndexList listTo;
+
+    for (qint32 i = 0; i < listFrom.count(); i++) {
+        qint64 nLineOffset = (qint64)listFrom.at(i).row() * m_nBytesPerLine;
+        listTo.append(createIndex((qint32)(nLineOffset / nBytesPerLine), listFrom.at(i).column()));
+    }
+
+    m_nBytesPerLine = nBytesPerLine;
+    _changeRowCount(_getRowCount(m_nBytesPerLine));
+
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_nFormattedRow = -1;
     }
-    return s;
+
+    changePersistentIndexList(listFrom, listTo);
+
+    emit layoutChanged();
 }
 
-QString XModel_Hex::_bytesToAscii(const QByteArray &ba) const
+qint32 XModel_Hex::getBytesPerLine() const
 {
-    QString s;
-    s.reserve(ba.size());
-    for (int i = 0; i < ba.size(); ++i) {
-        unsigned char c = (unsigned char)ba.at(i);
-        if (c >= 0x20 && c <= 0x7E) s.append(QChar(c));
-        else s.append('.');
+    return m_nBytesPerLine;
+}
+
+void XModel_Hex::setGrouping(qint32 nGroupSize, XBinary::ENDIAN endian)
+{
+    if ((nGroupSize != 1) && (nGroupSize != 2) && (nGroupSize != 4) && (nGroupSize != 8)) {
+        nGroupSize = 1;
+    }
+
+    if ((nGroupSize == m_nGroupSize) && (endian == m_groupEndian)) {
+        return;
+    }
+
+    m_nGroupSize = nGroupSize;
+    m_groupEndian = endian;
+
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_nFormattedRow = -1;
+    }
+
+    if (m_nBytesPerLine % m_nGroupSize) {
+        setBytesPerLine(m_nBytesPerLine);
     }
-    return s;
+
+    if (rowCount() > 0) {
+        emit dataChanged(index(0, COLUMN_HEX), index(rowCount() - 1, COLUMN_HEX));
+    }
+}
+
+qint32 XModel_Hex::getGroupSize() const
+{
+    return m_nGroupSize;
+}
+
+XBinary::ENDIAN XModel_Hex::getGroupEndian() const
+{
+    return m_groupEndian;
+}
+
+qint32 XModel_Hex::getFitBytesPerLine(qint32 nCharacters) const
+{
+    // A word takes two hex digits per byte plus a separator, and one ASCII character per byte
+    qint32 nGroups = (nCharacters + 1) / (m_nGroupSize * 3 + 1);
+
+    return qMax(nGroups, (qint32)1) * m_nGroupSize;
+}
+
+qint32 XModel_Hex::getRowForOffset(qint64 nDeviceOffset) const
+{
+    qint64 nRow = (nDeviceOffset - m_nOffset) / m_nBytesPerLine;
+
+    return (qint32)qBound((qint64)0, nRow, (qint64)qMax(rowCount() - 1, 0));
+}
+
+qint64 XModel_Hex::getOffsetForRow(qint32 nRow) const
+{
+    return m_nOffset + (qint64)nRow * m_nBytesPerLine;
+}
+
+qint32 XModel_Hex::_getRowCount(qint32 nBytesPerLine) const
+{
+    return (qint32)((m_nSize + nBytesPerLine - 1) / nBytesPerLine);
+}
+
+void XModel_Hex::clearCache()
+{
+    QMutexLocker locker(&m_cacheMutex);
+
+    m_hashPages.clear();
+    m_listPagesLRU.clear();
+    m_nFormattedRow = -1;
+    m_sFormattedHex.clear();
+    m_sFormattedAscii.clear();
+}
+
+qint64 XModel_Hex::getResidentSize() const
+{
+    QMutexLocker locker(&m_cacheMutex);
+
+    return XModel::getResidentSize() + m_hashPages.count() * N_HEX_PAGE_SIZE;
+}
+
+void XModel_Hex::releaseMemory()
+{
+    XModel::releaseMemory();
+    clearCache();
+}
+
+const QByteArray &XModel_Hex::_getPage(qint64 nPage) const
+{
+    QHash<qint64, QByteArray>::const_iterator iter = m_hashPages.constFind(nPage);
+
+    if (iter != m_hashPages.constEnd()) {
+        if (m_listPagesLRU.first() != nPage) {
+            m_listPagesLRU.removeOne(nPage);
+            m_listPagesLRU.prepend(nPage);
+        }
+
+        return iter.value();
+    }
+
+    if (m_listPagesLRU.count() >= N_HEX_PAGES) {
+        m_hashPages.remove(m_listPagesLRU.takeLast());
+    }
+
+    QByteArray baPage;
+    qint64 nPos = m_pDevice->pos();
+
+    if (m_pDevice->seek(nPage * N_HEX_PAGE_SIZE)) {
+        baPage = m_pDevice->read(N_HEX_PAGE_SIZE);
+    }
+
+    m_pDevice->seek(nPos);
+    m_listPagesLRU.prepend(nPage);
+
+    return m_hashPages.insert(nPage, baPage).value();
+}
+
+QByteArray XModel_Hex::_readLine(qint32 nRow) const
+{
+    qint64 nLineOffset = m_nOffset + (qint64)nRow * m_nBytesPerLine;
+    qint64 nLineSize = qMax((qint64)0, qMin((qint64)m_nBytesPerLine, m_nSize - ((qint64)nRow * m_nBytesPerLine)));
+    QByteArray baResult;
+    baResult.reserve((qint32)nLineSize);
+
+    // A line can cross a page boundary: at most two pages
+    while (nLineSize > 0) {
+        const QByteArray &baPage = _getPage(nLineOffset / N_HEX_PAGE_SIZE);
+        qint64 nPageOffset = nLineOffset % N_HEX_PAGE_SIZE;
+        qint64 nPart = qMin(nLineSize, N_HEX_PAGE_SIZE - nPageOffset);
+
+        if (nPageOffset + nPart > baPage.size()) {
+            nPart = baPage.size() - nPageOffset;  // End of the device
+        }
+
+        if (nPart <= 0) {
+            break;
+        }
+
+        baResult.append(baPage.constData() + nPageOffset, (qint32)nPart);
+        nLineOffset += nPart;
+        nLineSize -= nPart;
+    }
+
+    return baResult;
+}
+
+void XModel_Hex::_formatRow(qint32 nRow) const
+{
+    const XHEX_TABLES &tables = _getHexTables();
+    QByteArray baLine = _readLine(nRow);
+    qint32 nSize = baLine.size();
+    const uchar *pData = (const uchar *)baLine.constData();
+
+    qint32 nNumberOfGroups = (nSize + m_nGroupSize - 1) / m_nGroupSize;
+
+    m_sFormattedHex = QString(nSize ? (nSize * 2 + nNumberOfGroups - 1) : 0, Qt::Uninitialized);
+    m_sFormattedAscii = QString(nSize, Qt::Uninitialized);
+
+    ushort *pHex = (ushort *)m_sFormattedHex.data();
+    ushort *pAscii = (ushort *)m_sFormattedAscii.data();
+
+    for (qint32 i = 0; i < nSize; i += m_nGroupSize) {
+        qint32 nGroupSize = qMin(m_nGroupSize, nSize - i);
+        bool bReverse = (m_groupEndian == XBinary::ENDIAN_LITTLE) && (nGroupSize == m_nGroupSize);  // A trailing partial word keeps the byte order
+
+        if (i) {
+            *(pHex++) = ' ';
+        }
+
+        for (qint32 j = 0; j < nGroupSize; j++) {
+            uchar nByte = pData[i + (bReverse ? (nGroupSize - 1 - j) : j)];
+            *(pHex++) = tables.hex[nByte][0];
+            *(pHex++) = tables.hex[nByte][1];
+            pAscii[i + j] = tables.ascii[pData[i + j]];
+        }
+    }
+
+    m_nFormattedRow = nRow;
 }
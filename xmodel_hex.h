@@ -21,7 +21,10 @@
 #ifndef XMODEL_HEX_H
 #define XMODEL_HEX_H
 
+#include <QHash>
 #include <QIODevice>
+#include <QMutex>
+#include "xbinary.h"
 #include "xmodel.h"
 
 class XModel_Hex : public XModel {
@@ -40,15 +43,44 @@ public:
     QVariant data(const QModelIndex &index, int nRole = Qt::DisplayRole) const override;
     QVariant headerData(int nSection, Qt::Orientation orientation, int nRole = Qt::DisplayRole) const override;
 
+    // Relayout without a model reset: rows are recomputed arithmetically, the page cache is kept and
+    // the persistent indexes (selection, current index) follow their device offset
+    void setBytesPerLine(qint32 nBytesPerLine);
+    qint32 getBytesPerLine() const;
+    void setGrouping(qint32 nGroupSize, XBinary::ENDIAN endian);  // 1, 2, 4 or 8 bytes per hex word
+    qint32 getGroupSize() const;
+    XBinary::ENDIAN getGroupEndian() const;
+    qint32 getFitBytesPerLine(qint32 nCharacters) const;  // Most bytes whose hex and ASCII text fit in nCharacters
+    qint32 getRowForOffset(qint64 nDeviceOffset) const;   // For keeping the scroll position across a relayout
+    qint64 getOffsetForRow(qint32 nRow) const;
+
+    void clearCache();  // The device content changed
+    qint64 getResidentSize() const override;
+    void releaseMemory() override;
+
+protected:
+    qint32 _getColumnSymbolHint(qint32 nColumn) const override;
+
 private:
     QIODevice *m_pDevice;
     qint64 m_nOffset;
     qint64 m_nSize;
     quint64 m_nStartAddress;
     qint32 m_nBytesPerLine;
+    qint32 m_nGroupSize;
+    XBinary::ENDIAN m_groupEndian;
+
+    qint32 _getRowCount(qint32 nBytesPerLine) const;
+    QByteArray _readLine(qint32 nRow) const;
+    const QByteArray &_getPage(qint64 nPage) const;
+    void _formatRow(qint32 nRow) const;
 
-    QString _bytesToHex(const QByteArray &ba) const;
-    QString _bytesToAscii(const QByteArray &ba) const;
+    mutable QMutex m_cacheMutex;
+    mutable QHash<qint64, QByteArray> m_hashPages;  // Device pages around the viewport, one read each
+    mutable QList<qint64> m_listPagesLRU;           // Most recently used first
+    mutable qint32 m_nFormattedRow;                 // The three columns of a row share one formatting pass
+    mutable QString m_sFormattedHex;
+    mutable QString m_sFormattedAscii;
 };
 
 #endif  // XMODEL_HEX_H
@@ -20,11 +20,121 @@
  */
 
 #include "xmodel_msrecord.h"
+#include "xbatchreader.h"
 
 #include <limits>
+#include <QBuffer>
 #include <QFile>
+#include <QThread>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define XMSRECORD_SSE2
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define XMSRECORD_NEON
+#endif
 
 namespace {
+const qint32 N_VALUECACHE_BLOCK = 0x1000;  // Rows per parallel decode block
+const qint64 N_STRING_OVERHEAD = 32;       // Approximate heap overhead of a non-empty QString
+const qint64 N_HASH_NODE_OVERHEAD = 32;    // Approximate size of a QHash node with its share of the bucket array
+const qint32 N_SORT_PERMUTATIONS = 4;      // Ascending permutations kept for switching between sorted columns
+const qint32 N_LAZY_BATCH = 64;            // Lazily fetched values per dataChanged
+const qint32 N_LAZY_QUEUE_LIMIT = 0x400;   // Pending lazy requests; older ones were scrolled past
+const qint32 N_LAZY_VALUES_LIMIT = 0x10000;
+
+// Length of a NUL terminated 8-bit string, at most nMaxLength; memchr is vectorized by the C runtime
+qint32 _getStringLength8(const char *pData, qint32 nMaxLength)
+{
+    const void *pNull = memchr(pData, 0, nMaxLength);
+
+    return pNull ? (qint32)((const char *)pNull - pData) : nMaxLength;
+}
+
+// Length in code units of a NUL terminated UTF-16 string (either byte order), at most nMaxLength
+qint32 _getStringLength16(const quint16 *pData, qint32 nMaxLength)
+{
+    qint32 i = 0;
+
+#if defined(XMSRECORD_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 8 <= nMaxLength; i += 8) {
+        qint32 nMask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(pData + i)), zero));
+
+        if (nMask) {
+            return i + (qint32)(qCountTrailingZeroBits((quint32)nMask) / 2);
+        }
+    }
+#elif defined(XMSRECORD_NEON)
+    for (; i + 8 <= nMaxLength; i += 8) {
+        if (vmaxvq_u16(vceqzq_u16(vld1q_u16(pData + i)))) {
+            break;  // The scalar loop below finds the position inside this vector
+        }
+    }
+#endif
+
+    for (; i < nMaxLength; i++) {
+        if (pData[i] == 0) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+// UTF-16BE to QString: the code units are byte-swapped straight into the string buffer
+QString _utf16BEToString(const quint16 *pData, qint32 nLength)
+{
+    QString sResult(nLength, Qt::Uninitialized);
+    quint16 *pDest = reinterpret_cast<quint16 *>(sResult.data());
+    qint32 i = 0;
+
+#if defined(XMSRECORD_SSE2)
+    for (; i + 8 <= nLength; i += 8) {
+        __m128i value = _mm_loadu_si128((const __m128i *)(pData + i));
+        _mm_storeu_si128((__m128i *)(pDest + i), _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8)));
+    }
+#elif defined(XMSRECORD_NEON)
+    for (; i + 8 <= nLength; i += 8) {
+        vst1q_u8((uint8_t *)(pDest + i), vrev16q_u8(vld1q_u8((const uint8_t *)(pData + i))));
+    }
+#endif
+
+    for (; i < nLength; i++) {
+        pDest[i] = qbswap(pData[i]);
+    }
+
+    return sResult;
+}
+
+// Decodes a fixed-type string value from its raw record bytes
+QString _decodeStringData(XBinary::VT valueType, const char *pData, qint32 nSize, bool bBigEndian)
+{
+    QString sResult;
+
+    if ((valueType == XBinary::VT_A) || (valueType == XBinary::VT_A_I)) {
+        sResult = QString::fromLatin1(pData, _getStringLength8(pData, nSize));
+    } else if ((valueType == XBinary::VT_U) || (valueType == XBinary::VT_U_I)) {
+        const quint16 *pUData = (const quint16 *)pData;
+        qint32 nLen = _getStringLength16(pUData, nSize / 2);  // A zero code unit is zero in both byte orders
+
+        if (bBigEndian) {
+            sResult = _utf16BEToString(pUData, nLen);
+        } else {
+            sResult = QString::fromUtf16(reinterpret_cast<const char16_t *>(pUData), nLen);
+        }
+    } else if ((valueType == XBinary::VT_UTF8) || (valueType == XBinary::VT_UTF8_I)) {
+        sResult = QString::fromUtf8(pData, _getStringLength8(pData, nSize));
+    }
+
+    return sResult;
+}
+
 QIODevice *createINDATADevice(const XBinary::INDATA &inData)
 {
     QIODevice *pResult = nullptr;
@@ -130,9 +240,51 @@ XModel_MSRecord::XModel_MSRecord(const XBinary::INDATA &inData, const XBinary::_
 
 XModel_MSRecord::~XModel_MSRecord()
 {
+    _stopValueCache();
+
+    m_nLazyStop.storeRelease(1);
+    m_lazyFuture.waitForFinished();
+
+    delete m_pLazyFile;
+
+    if (m_bIsDeviceCreated) {
+        removeINDATADevice(m_pDevice, m_inData);
+    }
+}
+
+void XModel_MSRecord::prepareForDeferredDelete()
+{
+    XModel::prepareForDeferredDelete();
+
+    _stopValueCache();
+
+    // The lazy fetch worker reads the caller's records and the device: both may be gone once the model is handed over
+    m_nLazyStop.storeRelease(1);
+    m_lazyFuture.waitForFinished();
+    _clearLazyRequests();
+
+    delete m_pLazyFile;
+    m_pLazyFile = nullptr;
+
+    {
+        QMutexLocker locker(&m_lazyMutex);
+        m_listLazyReady.clear();
+    }
+
+    // The device and the store file are closed here, on the thread that opened them
     if (m_bIsDeviceCreated) {
         removeINDATADevice(m_pDevice, m_inData);
+        m_pDevice = nullptr;
+        m_bIsDeviceCreated = false;
+    }
+
+    if (m_pValueStoreMapped) {
+        m_valueStoreFile.unmap(const_cast<uchar *>(m_pValueStoreMapped));
+        m_pValueStoreMapped = nullptr;
+        m_vecValueStoreIndex.clear();
     }
+
+    m_valueStoreFile.close();
 }
 
 void XModel_MSRecord::_init(const XBinary::_MEMORY_MAP &memoryMap, QVector<XBinary::MS_RECORD> *pListRecods, XBinary::VT valueType)
@@ -144,6 +296,20 @@ void XModel_MSRecord::_init(const XBinary::_MEMORY_MAP &memoryMap, QVector<XBina
     m_endian = XBinary::ENDIAN_LITTLE;
     m_valueType = valueType;
     m_bValueCacheValid = false;
+    m_valuePool.nSize = 0;
+    m_pValueCacheWatcher = nullptr;
+    m_pValueCacheBuild = nullptr;
+    m_nRecordValuesSize = -1;
+    m_nDataGeneration = 0;
+    m_nPartialSortColumn = -1;
+    m_partialSortOrder = Qt::AscendingOrder;
+    m_bLazyValues = false;
+    m_pLazyFile = nullptr;
+    m_sLazyPlaceholder = tr("...");
+    m_bSpillOnRelease = false;
+    m_bLazyScheduled = false;
+    m_bLazyRunning = false;
+    m_nLazyGeneration = 0;
     m_pValueStoreMapped = nullptr;
 
     qint32 nRowCount = pListRecods->count();
@@ -176,20 +342,35 @@ void XModel_MSRecord::_init(const XBinary::_MEMORY_MAP &memoryMap, QVector<XBina
     }
 
     setColumnSymbolSize(COLUMN_REGION, nMaxRegionNameLength);
+
+    setColumnDisplayCache(COLUMN_OFFSET, true);
+    setColumnDisplayCache(COLUMN_ADDRESS, true);
+    setColumnDisplayCache(COLUMN_SIZE, true);
+    setColumnDisplayCache(COLUMN_INFO, true);
+    setColumnDisplayCache(COLUMN_VALUE, true);
 }
 
 void XModel_MSRecord::setValue(XBinary::ENDIAN endian, XBinary::VT valueType, QVariant varValue)
 {
+    _stopValueCache();
+
     m_endian = endian;
     m_valueType = valueType;
     m_varValue = varValue;
 
     m_sValue = XBinary::getValueString(varValue, valueType);
+
+    clearDisplayCache();
+    _invalidateDerivedValues();
 }
 
 void XModel_MSRecord::setSignaturesList(QList<XBinary::SIGNATUREDB_RECORD> *pListSignatureRecords)
 {
+    _stopValueCache();
+
     m_pListSignatureRecords = pListSignatureRecords;
+
+    _invalidateDerivedValues();
 }
 
 bool XModel_MSRecord::updateStringRecord(qint32 nRecordIndex, qint64 nSize, XBinary::VT valueType, const QString &sValue)
@@ -199,13 +380,18 @@ bool XModel_MSRecord::updateStringRecord(qint32 nRecordIndex, qint64 nSize, XBin
         return false;
     }
 
+    _stopValueCache();
+
     XBinary::MS_RECORD &record = (*m_pListRecords)[nRecordIndex];
     record.nSize = static_cast<quint16>(nSize);
     record.nValueType = static_cast<quint16>(valueType);
     record.sValue = sValue;
+    m_nRecordValuesSize = -1;
+    _invalidateDerivedValues();
 
-    if (m_bValueCacheValid && (nRecordIndex < m_vecValueCache.size())) {
-        m_vecValueCache[nRecordIndex] = sValue;
+    if (m_bValueCacheValid && (nRecordIndex < m_valuePool.vecIds.size())) {
+        // The old value stays in the pool: other records may still use its id
+        m_valuePool.vecIds[nRecordIndex] = _internValue(&m_valuePool, sValue);
     }
 
     const qint32 nModelRow = m_vecSortIndex.indexOf(nRecordIndex);
@@ -222,7 +408,11 @@ void XModel_MSRecord::invalidateStringRecord(qint32 nRecordIndex)
         return;
     }
 
+    _stopValueCache();
+
     (*m_pListRecords)[nRecordIndex].sValue.clear();
+    m_nRecordValuesSize = -1;
+    _invalidateDerivedValues();
     if (m_pValueStoreMapped) {
         m_valueStoreFile.unmap(const_cast<uchar *>(m_pValueStoreMapped));
         m_pValueStoreMapped = nullptr;
@@ -248,7 +438,14 @@ QVariant XModel_MSRecord::data(const QModelIndex &index, int nRole) const
             qint32 nDataRow = m_vecSortIndex.at(nRow);
             qint32 nColumn = index.column();
 
+            if ((nRole == Qt::DisplayRole) && _getDisplayCache(nRow, nColumn, &result)) {
+                return result;
+            }
+
             if (nRole == Qt::DisplayRole) {
+                bool bPending = false;
+                QString sPublishedValue;
+
                 if (nColumn == COLUMN_NUMBER) {
                     result = nDataRow;
                 } else if (nColumn == COLUMN_OFFSET) {
@@ -287,26 +484,20 @@ QVariant XModel_MSRecord::data(const QModelIndex &index, int nRole) const
                         result = m_pListRecords->at(nDataRow).sValue;
                     } else if (m_pValueStoreMapped) {
                         result = _readValueFromStore(nDataRow);  // Disk cache: keeps the exact decoded strings and is safe for the filter/sort threads
-                    } else if (m_bValueCacheValid && (nDataRow < m_vecValueCache.count())) {
-                        result = m_vecValueCache.at(nDataRow);
+                    } else if (m_bValueCacheValid && (nDataRow < m_valuePool.vecIds.count())) {
+                        result = m_valuePool.vecValues.at(m_valuePool.vecIds.at(nDataRow));
+                    } else if (_getPublishedValue(nDataRow, &sPublishedValue)) {
+                        result = sPublishedValue;  // Decoded by a running buildValueCache()
                     } else if (m_pDevice && ((m_valueType == XBinary::VT_STRING) || (m_valueType == XBinary::VT_A_I) || (m_valueType == XBinary::VT_U_I) ||
                                              (m_valueType == XBinary::VT_UTF8_I))) {
-                        XBinary binary(m_pDevice);
-                        const XBinary::MS_RECORD &record = m_pListRecords->at(nDataRow);
-                        XBinary::VT valueType = m_valueType;
-                        if (m_valueType == XBinary::VT_STRING) {
-                            valueType = (XBinary::VT)record.nValueType;
-                        }
-                        qint64 nRecordOffset = -1;
-                        if (getMSRecordOffset(m_memoryMap, record, &nRecordOffset)) {
-                            if (m_valueType == XBinary::VT_STRING) {
-                                result = binary.read_msRecordString(record, nRecordOffset);
-                            } else {
-                                XBinary::MS_RECORD fixedTypeRecord = record;
-                                fixedTypeRecord.nValueType = valueType;
-                                fixedTypeRecord.nInfo = (m_endian == XBinary::ENDIAN_BIG) ? XBinary::ENDIAN_BIG : XBinary::ENDIAN_LITTLE;
-                                result = binary.read_msRecordString(fixedTypeRecord, nRecordOffset);
-                            }
+                        if (m_bLazyValues && !isBulkAccess() && (QThread::currentThread() == thread())) {
+                            // Painting never waits for I/O: a placeholder now, the value with a later dataChanged
+                            bool bFetched = false;
+                            result = _getLazyValue(nRow, nDataRow, &bFetched);
+                            bPending = !bFetched;
+                        } else {
+                            XBinary binary(m_pDevice);
+                            result = _readValueFromDevice(&binary, nDataRow);
                         }
                     } else if (m_valueType == XBinary::VT_SIGNATURE) {
                         if (m_pListSignatureRecords && (m_pListSignatureRecords->count() > m_pListRecords->at(nDataRow).nInfo)) {
@@ -318,6 +509,10 @@ QVariant XModel_MSRecord::data(const QModelIndex &index, int nRole) const
                         result = m_sValue;
                     }
                 }
+
+                if (!bPending) {
+                    _setDisplayCache(nRow, nColumn, result);
+                }
             } else if (nRole == Qt::TextAlignmentRole) {
                 if ((nColumn == COLUMN_NUMBER) || (nColumn == COLUMN_OFFSET) || (nColumn == COLUMN_ADDRESS) || (nColumn == COLUMN_SIZE)) {
                     result = (qint32)Qt::AlignVCenter + (qint32)Qt::AlignRight;
@@ -391,6 +586,28 @@ QVariant XModel_MSRecord::headerData(int nSection, Qt::Orientation orientation,
     return result;
 }
 
+qint32 XModel_MSRecord::_getColumnSymbolHint(qint32 nColumn) const
+{
+    qint32 nResult = -1;
+
+    if (nColumn == COLUMN_NUMBER) {
+        nResult = QString::number(qMax(m_pListRecords->count() - 1, 0)).length();
+    } else if (nColumn == COLUMN_OFFSET) {
+        nResult = XBinary::getByteSizeFromWidthMode(m_modeOffset) * 2;
+    } else if (nColumn == COLUMN_ADDRESS) {
+        nResult = XBinary::getByteSizeFromWidthMode(m_modeAddress) * 2;
+    } else if (nColumn == COLUMN_REGION) {
+        nResult = 0;
+        qint32 nNumberOfRegions = m_memoryMap.listRecords.count();
+
+        for (qint32 i = 0; i < nNumberOfRegions; i++) {
+            nResult = qMax(nResult, m_memoryMap.listRecords.at(i).sName.length());
+        }
+    }
+
+    return nResult;
+}
+
 bool XModel_MSRecord::isCustomFilter()
 {
     return false;
@@ -426,16 +643,6 @@ quint64 XModel_MSRecord::getSortKeyHex(qint32 nRow, qint32 nColumn) const
     return 0;
 }
 
-static bool _compareSortHexAsc(const QPair<quint64, qint32> &a, const QPair<quint64, qint32> &b)
-{
-    return (a.first == b.first) ? (a.second < b.second) : (a.first < b.first);
-}
-
-static bool _compareSortHexDesc(const QPair<quint64, qint32> &a, const QPair<quint64, qint32> &b)
-{
-    return (a.first == b.first) ? (a.second < b.second) : (a.first > b.first);
-}
-
 static bool _compareSortTextAsc(const QPair<QString, qint32> &a, const QPair<QString, qint32> &b)
 {
     qint32 nCompare = QString::compare(a.first, b.first, Qt::CaseInsensitive);
@@ -445,69 +652,232 @@ static bool _compareSortTextAsc(const QPair<QString, qint32> &a, const QPair<QSt
     return (nCompare == 0) ? (a.second < b.second) : (nCompare < 0);
 }
 
-static bool _compareSortTextDesc(const QPair<QString, qint32> &a, const QPair<QString, qint32> &b)
-{
-    qint32 nCompare = QString::compare(a.first, b.first, Qt::CaseInsensitive);
-    if (nCompare == 0) {
-        nCompare = QString::compare(a.first, b.first, Qt::CaseSensitive);
-    }
-    return (nCompare == 0) ? (a.second < b.second) : (nCompare > 0);
-}
-
 void XModel_MSRecord::sortByColumn(qint32 nColumn, Qt::SortOrder order)
 {
     qint32 nRowCount = m_pListRecords->count();
+    QVector<qint32> vecAscending;
+    bool bCached = (nColumn != COLUMN_NUMBER) && _findSortPermutation(nColumn, &vecAscending);
+
+    _cancelPartialSort();
 
-    if ((nColumn == COLUMN_VALUE) && !m_bValueCacheValid && !m_pValueStoreMapped) {
+    if (!bCached && (nColumn == COLUMN_VALUE) && !m_bValueCacheValid && !m_pValueStoreMapped) {
         buildValueCache();  // With an active disk store the values are read directly from it below
+        waitForValueCache();
     }
 
-    emit layoutAboutToBeChanged();
+    // Partial sort only where the keys cost O(n): the text columns are ranked by a full sort anyway
+    bool bPartial = !bCached && (nColumn != COLUMN_NUMBER) && _isPartialSort(nRowCount) &&
+                    ((getSortMethod(nColumn) == SORT_METHOD_HEX) || ((nColumn == COLUMN_VALUE) && m_bValueCacheValid));
 
-    m_vecSortIndex.resize(nRowCount);
+    emit layoutAboutToBeChanged();
 
     if (nColumn == COLUMN_NUMBER) {
+        m_vecSortIndex.resize(nRowCount);
+
         for (qint32 i = 0; i < nRowCount; i++) {
             m_vecSortIndex[i] = i;
         }
+    } else if (bPartial) {
+        // Same tie rule as the reversed cached permutation below: the background result has the same top rows
+        m_nPartialSortColumn = nColumn;
+        m_partialSortOrder = order;
+        m_vecSortIndex = _startPartialSort(_computeSortKeys(nColumn), order);
+    } else {
+        if (!bCached) {
+            vecAscending = _computeSortPermutation(nColumn);
+            _addSortPermutation(nColumn, vecAscending);
+        }
+
+        m_vecSortIndex = vecAscending;
+    }
+
+    // Only ascending permutations are computed and kept; descending is the reverse
+    if ((order == Qt::DescendingOrder) && !bPartial) {
+        std::reverse(m_vecSortIndex.begin(), m_vecSortIndex.end());
+    }
+
+    _clearLazyRequests();
+
+    emit layoutChanged();
+}
+
+void XModel_MSRecord::_applyPartialSortResult(const QVector<qint32> &vecIndex)
+{
+    if (m_partialSortOrder == Qt::AscendingOrder) {
+        _addSortPermutation(m_nPartialSortColumn, vecIndex);
+    } else {
+        // Descending is the reversed ascending order, so it can be kept as well
+        QVector<qint32> vecAscending = vecIndex;
+        std::reverse(vecAscending.begin(), vecAscending.end());
+        _addSortPermutation(m_nPartialSortColumn, vecAscending);
+    }
+
+    emit layoutAboutToBeChanged();
+
+    m_vecSortIndex = vecIndex;
+    _clearLazyRequests();
+
+    emit layoutChanged();
+}
+
+void XModel_MSRecord::_clearLazyRequests()
+{
+    QMutexLocker locker(&m_lazyMutex);
+    m_listLazyQueue.clear();
+    m_setLazyRequested.clear();
+}
+
+void XModel_MSRecord::sortByColumns(const QList<SORT_COLUMN> &listColumns)
+{
+    if (listColumns.count() <= 1) {
+        if (listColumns.count() == 1) {
+            sortByColumn(listColumns.at(0).nColumn, listColumns.at(0).order);
+        }
 
-        if (order == Qt::DescendingOrder) {
-            std::reverse(m_vecSortIndex.begin(), m_vecSortIndex.end());
+        return;
+    }
+
+    _cancelPartialSort();
+
+    bool bValueColumn = false;
+
+    for (qint32 i = 0; i < listColumns.count(); i++) {
+        bValueColumn = bValueColumn || (listColumns.at(i).nColumn == COLUMN_VALUE);
+    }
+
+    if (bValueColumn && !m_bValueCacheValid && !m_pValueStoreMapped) {
+        buildValueCache();
+        waitForValueCache();
+    }
+
+    QVector<qint32> vecIndex;
+
+    if (computeRowOrder(listColumns, &vecIndex, _resetSortCancel())) {
+        applyRowOrder(vecIndex);
+    }
+}
+
+bool XModel_MSRecord::computeRowOrder(const QList<SORT_COLUMN> &listColumns, QVector<qint32> *pVecRowOrder, QAtomicInt *pCancelFlag) const
+{
+    // One key per column, descending keys inverted, then a stable sort of the packed composite key
+    qint32 nRowCount = m_pListRecords->count();
+    QList<QVector<quint64>> listKeys;
+
+    pVecRowOrder->clear();
+
+    for (qint32 i = 0; i < listColumns.count(); i++) {
+        QVector<quint64> vecKeys = _computeSortKeys(listColumns.at(i).nColumn, pCancelFlag);
+
+        if (pCancelFlag && pCancelFlag->loadAcquire()) {
+            return false;
+        }
+
+        if (listColumns.at(i).order == Qt::DescendingOrder) {
+            for (qint32 j = 0; j < nRowCount; j++) {
+                vecKeys[j] = ~vecKeys.at(j);
+            }
         }
 
-        emit layoutChanged();
+        listKeys.append(vecKeys);
+    }
+
+    if (listKeys.count() == 1) {
+        *pVecRowOrder = getSortPermutation(listKeys.at(0), Qt::AscendingOrder);
+    } else if (listKeys.count() > 1) {
+        *pVecRowOrder = getMultiSortPermutation(listKeys, pCancelFlag);
+    }
+
+    return !(pCancelFlag && pCancelFlag->loadAcquire());
+}
+
+void XModel_MSRecord::applyRowOrder(const QVector<qint32> &vecRowOrder)
+{
+    _cancelPartialSort();
+
+    qint32 nRowCount = m_pListRecords->count();
+
+    if (!vecRowOrder.isEmpty() && (vecRowOrder.count() != nRowCount)) {
         return;
     }
 
-    SORT_METHOD sortMethod = getSortMethod(nColumn);
+    emit layoutAboutToBeChanged();
 
-    if (sortMethod == SORT_METHOD_HEX) {
-        QVector<QPair<quint64, qint32>> vecPairs(nRowCount);
+    if (vecRowOrder.isEmpty()) {
+        m_vecSortIndex.resize(nRowCount);
 
         for (qint32 i = 0; i < nRowCount; i++) {
-            vecPairs[i].first = _getRawSortKey(i, nColumn);
-            vecPairs[i].second = i;
+            m_vecSortIndex[i] = i;
         }
+    } else {
+        m_vecSortIndex = vecRowOrder;
+    }
 
-        if (order == Qt::AscendingOrder) {
-            std::sort(vecPairs.begin(), vecPairs.end(), _compareSortHexAsc);
-        } else {
-            std::sort(vecPairs.begin(), vecPairs.end(), _compareSortHexDesc);
+    _clearLazyRequests();
+
+    emit layoutChanged();
+}
+
+QVector<qint32> XModel_MSRecord::_computeSortPermutation(qint32 nColumn)
+{
+    return getSortPermutation(_computeSortKeys(nColumn), Qt::AscendingOrder);
+}
+
+QVector<quint64> XModel_MSRecord::_computeSortKeys(qint32 nColumn, QAtomicInt *pCancelFlag) const
+{
+    qint32 nRowCount = m_pListRecords->count();
+    QVector<quint64> vecResult(nRowCount);
+    SORT_METHOD sortMethod = const_cast<XModel_MSRecord *>(this)->getSortMethod(nColumn);  // Depends on the column only
+
+    if (nColumn == COLUMN_NUMBER) {
+        for (qint32 i = 0; i < nRowCount; i++) {
+            vecResult[i] = i;
+        }
+    } else if (sortMethod == SORT_METHOD_HEX) {
+        for (qint32 i = 0; i < nRowCount; i++) {
+            if (pCancelFlag && ((i & 0xFFFF) == 0) && pCancelFlag->loadAcquire()) {
+                return QVector<quint64>();
+            }
+
+            vecResult[i] = _getRawSortKey(i, nColumn);
+        }
+    } else if ((nColumn == COLUMN_VALUE) && m_bValueCacheValid) {
+        // Interned values: the distinct strings are compared once, the rows are ordered by the rank of their id
+        qint32 nNumberOfValues = m_valuePool.vecValues.count();
+        QVector<QPair<QString, qint32>> vecValues(nNumberOfValues);
+
+        for (qint32 i = 0; i < nNumberOfValues; i++) {
+            vecValues[i].first = m_valuePool.vecValues.at(i);
+            vecValues[i].second = i;
+        }
+
+        std::sort(vecValues.begin(), vecValues.end(), _compareSortTextAsc);
+
+        QVector<quint64> vecRanks(nNumberOfValues);
+        quint64 nRank = 0;
+
+        for (qint32 i = 0; i < nNumberOfValues; i++) {
+            if ((i > 0) && (vecValues.at(i).first != vecValues.at(i - 1).first)) {
+                nRank++;
+            }
+
+            vecRanks[vecValues.at(i).second] = nRank;
         }
 
         for (qint32 i = 0; i < nRowCount; i++) {
-            m_vecSortIndex[i] = vecPairs[i].second;
+            vecResult[i] = vecRanks.at(m_valuePool.vecIds.at(i));
         }
     } else {
         QVector<QPair<QString, qint32>> vecPairs(nRowCount);
 
         for (qint32 i = 0; i < nRowCount; i++) {
+            if (pCancelFlag && ((i & 0xFFFF) == 0) && pCancelFlag->loadAcquire()) {
+                return QVector<quint64>();
+            }
+
             if ((nColumn == COLUMN_VALUE) && !m_pListRecords->at(i).sValue.isEmpty()) {
                 vecPairs[i].first = m_pListRecords->at(i).sValue;
             } else if ((nColumn == COLUMN_VALUE) && m_pValueStoreMapped) {
                 vecPairs[i].first = _readValueFromStore(i);
-            } else if ((nColumn == COLUMN_VALUE) && m_bValueCacheValid) {
-                vecPairs[i].first = m_vecValueCache.at(i);
             } else if (nColumn == COLUMN_REGION) {
                 const qint32 nRegionIndex = m_pListRecords->at(i).nRegionIndex;
                 if (isValidMemoryRecordIndex(m_memoryMap, nRegionIndex)) {
@@ -519,222 +889,823 @@ void XModel_MSRecord::sortByColumn(qint32 nColumn, Qt::SortOrder order)
             vecPairs[i].second = i;
         }
 
-        if (order == Qt::AscendingOrder) {
-            std::sort(vecPairs.begin(), vecPairs.end(), _compareSortTextAsc);
-        } else {
-            std::sort(vecPairs.begin(), vecPairs.end(), _compareSortTextDesc);
-        }
+        std::sort(vecPairs.begin(), vecPairs.end(), _compareSortTextAsc);
+
+        quint64 nRank = 0;
 
         for (qint32 i = 0; i < nRowCount; i++) {
-            m_vecSortIndex[i] = vecPairs[i].second;
+            if ((i > 0) && (vecPairs.at(i).first != vecPairs.at(i - 1).first)) {
+                nRank++;
+            }
+
+            vecResult[vecPairs.at(i).second] = nRank;
         }
     }
 
-    emit layoutChanged();
+    return vecResult;
 }
 
-quint64 XModel_MSRecord::_getRawSortKey(qint32 nDataRow, qint32 nColumn) const
+bool XModel_MSRecord::_findSortPermutation(qint32 nColumn, QVector<qint32> *pVecIndex)
 {
-    quint64 nResult = 0;
+    qint32 nNumberOfPermutations = m_listSortPermutations.count();
 
-    if ((nDataRow >= 0) && (nDataRow < m_pListRecords->count())) {
-        if (nColumn == COLUMN_OFFSET) {
-            qint64 nRecordOffset = -1;
-            if (getMSRecordOffset(m_memoryMap, m_pListRecords->at(nDataRow), &nRecordOffset)) {
-                nResult = nRecordOffset;
-            }
-        } else if (nColumn == COLUMN_ADDRESS) {
-            XADDR nRecordAddress = (XADDR)-1;
-            if (getMSRecordAddress(m_memoryMap, m_pListRecords->at(nDataRow), &nRecordAddress)) {
-                nResult = nRecordAddress;
-            }
-        } else if (nColumn == COLUMN_SIZE) {
-            nResult = m_pListRecords->at(nDataRow).nSize;
+    for (qint32 i = 0; i < nNumberOfPermutations; i++) {
+        const SORT_PERMUTATION &permutation = m_listSortPermutations.at(i);
+
+        if ((permutation.nColumn == nColumn) && (permutation.nGeneration == m_nDataGeneration)) {
+            *pVecIndex = permutation.vecIndex;
+            m_listSortPermutations.move(i, 0);  // Most recently used first
+
+            return true;
         }
     }
 
-    return nResult;
+    return false;
 }
 
-void XModel_MSRecord::buildValueCache()
+void XModel_MSRecord::_addSortPermutation(qint32 nColumn, const QVector<qint32> &vecIndex)
 {
-    qint32 nRowCount = m_pListRecords->count();
-    m_vecValueCache.resize(nRowCount);
+    SORT_PERMUTATION permutation = {};
+    permutation.nColumn = nColumn;
+    permutation.nGeneration = m_nDataGeneration;
+    permutation.vecIndex = vecIndex;
 
-    if (m_pValueStoreMapped) {
-        // The values are cached on disk: read them back from the store, not from the device
-        for (qint32 i = 0; i < nRowCount; i++) {
-            m_vecValueCache[i] = _readValueFromStore(i);
-        }
+    m_listSortPermutations.prepend(permutation);
 
-        m_bValueCacheValid = true;
-        return;
+    while (m_listSortPermutations.count() > N_SORT_PERMUTATIONS) {
+        m_listSortPermutations.removeLast();
     }
+}
 
-    if (!m_pDevice) {
-        m_bValueCacheValid = true;
-        return;
-    }
+void XModel_MSRecord::_invalidateDerivedValues()
+{
+    m_nDataGeneration++;
+    m_listSortPermutations.clear();
+    _cancelPartialSort();
 
-    // Try memory mapping for fast access (avoids per-byte I/O)
-    QFile *pFile = qobject_cast<QFile *>(m_pDevice);
-    qint64 nFileSize = m_pDevice->size();
-    uchar *pMapped = nullptr;
+    QMutexLocker locker(&m_lazyMutex);
+    m_nLazyGeneration++;  // Values still in flight are dropped by the worker
+    m_hashLazyValues.clear();
+}
 
-    if (pFile && (nFileSize > 0)) {
-        pMapped = pFile->map(0, nFileSize);
+void XModel_MSRecord::setLazyValuesEnabled(bool bEnabled)
+{
+    // The worker reads its own handle on the file: the caller's device may be used by others without m_deviceMutex.
+    // Other devices stay on the GUI thread, data() reads them directly.
+    if (bEnabled && !m_pLazyFile) {
+        m_pLazyFile = _openPrivateFile();
     }
 
-    if (pMapped) {
-        bool bBigEndian = (m_endian == XBinary::ENDIAN_BIG);
-        XBinary binary(m_pDevice);
+    m_bLazyValues = bEnabled && (m_pLazyFile != nullptr);
+}
 
-        for (qint32 i = 0; i < nRowCount; i++) {
-            QString sValue;
+bool XModel_MSRecord::isLazyValuesEnabled() const
+{
+    return m_bLazyValues;
+}
 
-            if (!m_pListRecords->at(i).sValue.isEmpty()) {
-                sValue = m_pListRecords->at(i).sValue;
-            } else if ((m_valueType == XBinary::VT_STRING) || (m_valueType == XBinary::VT_A_I) || (m_valueType == XBinary::VT_U_I) || (m_valueType == XBinary::VT_UTF8_I)) {
-                const XBinary::MS_RECORD &record = m_pListRecords->at(i);
-                XBinary::VT valueType = m_valueType;
+void XModel_MSRecord::setSpillOnReleaseEnabled(bool bEnabled)
+{
+    m_bSpillOnRelease = bEnabled;
+}
 
-                if (m_valueType == XBinary::VT_STRING) {
-                    valueType = (XBinary::VT)record.nValueType;
-                }
+bool XModel_MSRecord::isSpillOnReleaseEnabled() const
+{
+    return m_bSpillOnRelease;
+}
 
-                qint64 nOffset = -1;
-                getMSRecordOffset(m_memoryMap, record, &nOffset);
+QString XModel_MSRecord::_getLazyValue(qint32 nRow, qint32 nDataRow, bool *pbFetched) const
+{
+    QMutexLocker locker(&m_lazyMutex);
 
-                qint64 nSize = qMin((qint64)record.nSize, (qint64)128);
-                const qint64 nRequiredSize = (m_valueType == XBinary::VT_STRING) ? record.nSize : nSize;
+    QHash<qint32, QString>::const_iterator iter = m_hashLazyValues.constFind(nDataRow);
 
-                if ((nOffset >= 0) && (nOffset <= nFileSize) && (nRequiredSize <= nFileSize - nOffset)) {
-                    const char *pData = (const char *)(pMapped + nOffset);
+    if (iter != m_hashLazyValues.constEnd()) {
+        *pbFetched = true;
+        return iter.value();
+    }
 
-                    if (m_valueType == XBinary::VT_STRING) {
-                        sValue = binary.read_msRecordString(record, nOffset);
-                    } else if ((valueType == XBinary::VT_A) || (valueType == XBinary::VT_A_I)) {
-                        qint32 nLen = 0;
+    *pbFetched = false;
 
-                        for (qint32 j = 0; j < nSize; j++) {
-                            if (pData[j] == 0) {
-                                break;
-                            }
+    if (!m_setLazyRequested.contains(nDataRow)) {
+        m_setLazyRequested.insert(nDataRow);
+        m_listLazyQueue.append(qMakePair(nDataRow, nRow));
 
-                            nLen++;
-                        }
+        if (m_listLazyQueue.count() > N_LAZY_QUEUE_LIMIT) {
+            // Scrolled past: the oldest requests are not visible anymore
+            m_setLazyRequested.remove(m_listLazyQueue.first().first);
+            m_listLazyQueue.removeFirst();
+        }
 
-                        sValue = QString::fromLatin1(pData, nLen);
-                    } else if ((valueType == XBinary::VT_U) || (valueType == XBinary::VT_U_I)) {
-                        qint32 nCharCount = nSize / 2;
-                        qint32 nLen = 0;
-                        const quint16 *pUData = (const quint16 *)pData;
+        if (!m_bLazyScheduled) {
+            m_bLazyScheduled = true;
+            QMetaObject::invokeMethod(const_cast<XModel_MSRecord *>(this), "_startLazyFetch", Qt::QueuedConnection);
+        }
+    }
 
-                        for (qint32 j = 0; j < nCharCount; j++) {
-                            quint16 nCh = pUData[j];
+    return m_sLazyPlaceholder;
+}
 
-                            if (bBigEndian) {
-                                nCh = ((nCh >> 8) & 0xFF) | ((nCh << 8) & 0xFF00);
-                            }
+void XModel_MSRecord::_startLazyFetch()
+{
+    QVector<VALUE_READ> vecRequests;
+    XBinary::VT valueType = XBinary::VT_UNKNOWN;
+    bool bBigEndian = false;
+    qint32 nGeneration = 0;
 
-                            if (nCh == 0) {
-                                break;
-                            }
+    {
+        QMutexLocker locker(&m_lazyMutex);
+        m_bLazyScheduled = false;
 
-                            nLen++;
-                        }
+        if (m_bLazyRunning || m_listLazyQueue.isEmpty() || m_nLazyStop.loadAcquire()) {
+            return;  // A running sweep starts the next one when it is done
+        }
 
-                        if (bBigEndian) {
-                            QVector<quint16> vecSwapped(nLen);
+        // The worker gets copies: updateStringRecord(), invalidateStringRecord() and setValue() change
+        // the records, the value type and the endianness on the GUI thread while it reads
+        qint32 nNumberOfRequests = m_listLazyQueue.count();
+        vecRequests.resize(nNumberOfRequests);
 
-                            for (qint32 j = 0; j < nLen; j++) {
-                                quint16 nCh = pUData[j];
-                                vecSwapped[j] = ((nCh >> 8) & 0xFF) | ((nCh << 8) & 0xFF00);
-                            }
+        for (qint32 i = 0; i < nNumberOfRequests; i++) {
+            vecRequests[i] = _getValueRead(m_listLazyQueue.at(i).first);
+            vecRequests[i].nRow = m_listLazyQueue.at(i).second;
+        }
 
-                            sValue = QString::fromUtf16(
-                                reinterpret_cast<const char16_t *>(vecSwapped.constData()), nLen);
-                        } else {
-                            sValue = QString::fromUtf16(
-                                reinterpret_cast<const char16_t *>(pUData), nLen);
-                        }
-                    } else if ((valueType == XBinary::VT_UTF8) || (valueType == XBinary::VT_UTF8_I)) {
-                        qint32 nLen = 0;
+        m_listLazyQueue.clear();
+        valueType = m_valueType;
+        bBigEndian = (m_endian == XBinary::ENDIAN_BIG);
+        nGeneration = m_nLazyGeneration;
+        m_bLazyRunning = true;
+    }
 
-                        for (qint32 j = 0; j < nSize; j++) {
-                            if (pData[j] == 0) {
-                                break;
-                            }
+    // One sequential sweep: the requested records are read in file offset order
+    qint32 nNumberOfRequests = vecRequests.count();
+    QVector<quint64> vecOffsets(nNumberOfRequests);
 
-                            nLen++;
-                        }
+    for (qint32 i = 0; i < nNumberOfRequests; i++) {
+        vecOffsets[i] = (quint64)vecRequests.at(i).nOffset;  // -1 (not in the file) goes last
+    }
+
+    QVector<qint32> vecOrder = getSortPermutation(vecOffsets, Qt::AscendingOrder);
+    QVector<VALUE_READ> vecSorted(nNumberOfRequests);
+
+    for (qint32 i = 0; i < nNumberOfRequests; i++) {
+        vecSorted[i] = vecRequests.at(vecOrder.at(i));
+    }
+
+    m_lazyFuture = QtConcurrent::run(_lazyFetchThread, this, vecSorted, valueType, bBigEndian, nGeneration);
+}
+
+void XModel_MSRecord::_lazyFetchThread(XModel_MSRecord *pModel, const QVector<VALUE_READ> &vecRequests, XBinary::VT valueType, bool bBigEndian,
+                                       qint32 nGeneration)
+{
+    qint32 nNumberOfRequests = vecRequests.count();
+    QVector<QString> vecValues;
+
+    for (qint32 i = 0; (i < nNumberOfRequests) && !pModel->m_nLazyStop.loadAcquire(); i += N_LAZY_BATCH) {
+        qint32 nBatchSize = qMin(N_LAZY_BATCH, nNumberOfRequests - i);
+        vecValues.fill(QString(), nBatchSize);
+
+        // Only the snapshot and the private file are read here, never m_pListRecords or m_pDevice
+        pModel->_readValues(pModel->m_pLazyFile, vecRequests.constData() + i, nBatchSize, valueType, bBigEndian, vecValues.data());
 
-                        sValue = QString::fromUtf8(pData, nLen);
+        {
+            QMutexLocker locker(&pModel->m_lazyMutex);
+
+            for (qint32 j = 0; j < nBatchSize; j++) {
+                const VALUE_READ &request = vecRequests.at(i + j);
+                pModel->m_setLazyRequested.remove(request.nDataRow);
+
+                if (nGeneration == pModel->m_nLazyGeneration) {
+                    if (pModel->m_hashLazyValues.count() >= N_LAZY_VALUES_LIMIT) {
+                        pModel->m_hashLazyValues.clear();  // Bounded: rows scrolled out of view are fetched again when needed
                     }
+
+                    pModel->m_hashLazyValues.insert(request.nDataRow, vecValues.at(j));
+                    pModel->m_listLazyReady.append(request.nRow);
                 }
-            } else if (m_valueType == XBinary::VT_SIGNATURE) {
-                if (m_pListSignatureRecords && (m_pListSignatureRecords->count() > m_pListRecords->at(i).nInfo)) {
-                    sValue = m_pListSignatureRecords->at(m_pListRecords->at(i).nInfo).sName;
-                } else {
-                    sValue = m_sValue;
-                }
+            }
+        }
+
+        QMetaObject::invokeMethod(pModel, "_onLazyValuesReady", Qt::QueuedConnection);
+    }
+
+    {
+        QMutexLocker locker(&pModel->m_lazyMutex);
+        pModel->m_bLazyRunning = false;
+    }
+
+    QMetaObject::invokeMethod(pModel, "_startLazyFetch", Qt::QueuedConnection);
+}
+
+void XModel_MSRecord::_onLazyValuesReady()
+{
+    QList<qint32> listRows;
+
+    {
+        QMutexLocker locker(&m_lazyMutex);
+        listRows.swap(m_listLazyReady);
+    }
+
+    qint32 nRowCount = rowCount();
+    qint32 nMinRow = nRowCount;
+    qint32 nMaxRow = -1;
+
+    for (qint32 i = 0; i < listRows.count(); i++) {
+        qint32 nRow = listRows.at(i);
+
+        if (nRow < nRowCount) {
+            nMinRow = qMin(nMinRow, nRow);
+            nMaxRow = qMax(nMaxRow, nRow);
+        }
+    }
+
+    if (nMaxRow >= nMinRow) {
+        // Filter and sort results were computed from the real values: not a content change for them
+        emit dataChanged(index(nMinRow, COLUMN_VALUE), index(nMaxRow, COLUMN_VALUE), QVector<int>() << (Qt::UserRole + XModel::USERROLE_FETCHED));
+    }
+}
+
+QString XModel_MSRecord::_readValueFromDevice(XBinary *pBinary, qint32 nDataRow) const
+{
+    QString sResult;
+    const XBinary::MS_RECORD &record = m_pListRecords->at(nDataRow);
+    XBinary::VT valueType = m_valueType;
+
+    if (m_valueType == XBinary::VT_STRING) {
+        valueType = (XBinary::VT)record.nValueType;
+    }
+
+    qint64 nRecordOffset = -1;
+
+    if (getMSRecordOffset(m_memoryMap, record, &nRecordOffset)) {
+        QMutexLocker locker(&m_deviceMutex);  // Shared with the lazy fetch worker
+
+        if (m_valueType == XBinary::VT_STRING) {
+            sResult = pBinary->read_msRecordString(record, nRecordOffset);
+        } else {
+            XBinary::MS_RECORD fixedTypeRecord = record;
+            fixedTypeRecord.nValueType = valueType;
+            fixedTypeRecord.nInfo = (m_endian == XBinary::ENDIAN_BIG) ? XBinary::ENDIAN_BIG : XBinary::ENDIAN_LITTLE;
+            sResult = pBinary->read_msRecordString(fixedTypeRecord, nRecordOffset);
+        }
+    }
+
+    return sResult;
+}
+
+XModel_MSRecord::VALUE_READ XModel_MSRecord::_getValueRead(qint32 nDataRow) const
+{
+    VALUE_READ result;
+    result.nDataRow = nDataRow;
+    result.nRow = -1;
+    result.record = m_pListRecords->at(nDataRow);
+    result.nOffset = -1;
+
+    if (!getMSRecordOffset(m_memoryMap, result.record, &result.nOffset)) {
+        result.nOffset = -1;
+    }
+
+    return result;
+}
+
+QFile *XModel_MSRecord::_openPrivateFile() const
+{
+    QFile *pResult = nullptr;
+    QFile *pFile = qobject_cast<QFile *>(m_pDevice);
+
+    if (pFile && !pFile->fileName().isEmpty()) {
+        pResult = new QFile(pFile->fileName());
+
+        if (!pResult->open(QIODevice::ReadOnly)) {
+            delete pResult;
+            pResult = nullptr;
+        }
+    }
+
+    return pResult;
+}
+
+void XModel_MSRecord::_readValuesFromDevice(QIODevice *pDevice, const qint32 *pRows, qint32 nCount, QString *pValues) const
+{
+    QVector<VALUE_READ> vecRequests(nCount);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        vecRequests[i] = _getValueRead(pRows[i]);
+    }
+
+    _readValues(pDevice, vecRequests.constData(), nCount, m_valueType, (m_endian == XBinary::ENDIAN_BIG), pValues);
+}
+
+void XModel_MSRecord::_readValues(QIODevice *pDevice, const VALUE_READ *pRequests, qint32 nCount, XBinary::VT valueType, bool bBigEndian,
+                                  QString *pValues) const
+{
+    // The shared device is locked until the batch reader has unmapped it: QFile::map()/unmap() are not thread-safe
+    QMutexLocker locker((pDevice == m_pDevice) ? &m_deviceMutex : nullptr);
+
+    // The records are gathered and read in file offset order: nearby records share one sequential read
+    XBatchReader batchReader;
+    QVector<qint32> vecReadIndexes(nCount, -1);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        const XBinary::MS_RECORD &record = pRequests[i].record;
+
+        if (pRequests[i].nOffset != -1) {
+            qint64 nSize = (valueType == XBinary::VT_STRING) ? record.nSize : qMin((qint64)record.nSize, (qint64)128);
+            vecReadIndexes[i] = batchReader.addRead(pRequests[i].nOffset, nSize);
+        }
+    }
+
+    batchReader.execute(pDevice);
+
+    // read_msRecordString needs a device: a buffer that is pointed at each record in turn
+    QByteArray baRecord;
+    QBuffer buffer(&baRecord);
+    buffer.open(QIODevice::ReadOnly);
+    XBinary binary(&buffer);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        qint64 nDataSize = 0;
+        const char *pData = batchReader.getData(vecReadIndexes.at(i), &nDataSize);
+
+        if (!pData) {
+            continue;
+        }
+
+        const XBinary::MS_RECORD &record = pRequests[i].record;
+
+        if (valueType == XBinary::VT_STRING) {
+            if (nDataSize >= record.nSize) {
+                baRecord.setRawData(pData, (quint32)nDataSize);
+                pValues[i] = binary.read_msRecordString(record, 0);
+            }
+        } else if (nDataSize >= qMin((qint64)record.nSize, (qint64)128)) {
+            pValues[i] = _decodeStringData(valueType, pData, (qint32)nDataSize, bBigEndian);
+        }
+    }
+}
+
+quint64 XModel_MSRecord::_getRawSortKey(qint32 nDataRow, qint32 nColumn) const
+{
+    quint64 nResult = 0;
+
+    if ((nDataRow >= 0) && (nDataRow < m_pListRecords->count())) {
+        if (nColumn == COLUMN_OFFSET) {
+            qint64 nRecordOffset = -1;
+            if (getMSRecordOffset(m_memoryMap, m_pListRecords->at(nDataRow), &nRecordOffset)) {
+                nResult = nRecordOffset;
+            }
+        } else if (nColumn == COLUMN_ADDRESS) {
+            XADDR nRecordAddress = (XADDR)-1;
+            if (getMSRecordAddress(m_memoryMap, m_pListRecords->at(nDataRow), &nRecordAddress)) {
+                nResult = nRecordAddress;
+            }
+        } else if (nColumn == COLUMN_SIZE) {
+            nResult = m_pListRecords->at(nDataRow).nSize;
+        }
+    }
+
+    return nResult;
+}
+
+QString XModel_MSRecord::_decodeMappedValue(qint32 nDataRow, const uchar *pMapped, qint64 nFileSize, XBinary *pBinary) const
+{
+    bool bBigEndian = (m_endian == XBinary::ENDIAN_BIG);
+    QString sValue;
+
+    if (!m_pListRecords->at(nDataRow).sValue.isEmpty()) {
+        sValue = m_pListRecords->at(nDataRow).sValue;
+    } else if ((m_valueType == XBinary::VT_STRING) || (m_valueType == XBinary::VT_A_I) || (m_valueType == XBinary::VT_U_I) || (m_valueType == XBinary::VT_UTF8_I)) {
+        const XBinary::MS_RECORD &record = m_pListRecords->at(nDataRow);
+        XBinary::VT valueType = m_valueType;
+
+        if (m_valueType == XBinary::VT_STRING) {
+            valueType = (XBinary::VT)record.nValueType;
+        }
+
+        qint64 nOffset = -1;
+        getMSRecordOffset(m_memoryMap, record, &nOffset);
+
+        qint64 nSize = qMin((qint64)record.nSize, (qint64)128);
+        const qint64 nRequiredSize = (m_valueType == XBinary::VT_STRING) ? record.nSize : nSize;
+
+        if ((nOffset >= 0) && (nOffset <= nFileSize) && (nRequiredSize <= nFileSize - nOffset)) {
+            const char *pData = (const char *)(pMapped + nOffset);
+
+            if (m_valueType == XBinary::VT_STRING) {
+                sValue = pBinary->read_msRecordString(record, nOffset);
             } else {
-                sValue = m_sValue;
+                sValue = _decodeStringData(valueType, pData, (qint32)nSize, bBigEndian);
             }
+        }
+    } else if (m_valueType == XBinary::VT_SIGNATURE) {
+        if (m_pListSignatureRecords && (m_pListSignatureRecords->count() > m_pListRecords->at(nDataRow).nInfo)) {
+            sValue = m_pListSignatureRecords->at(m_pListRecords->at(nDataRow).nInfo).sName;
+        } else {
+            sValue = m_sValue;
+        }
+    } else {
+        sValue = m_sValue;
+    }
+
+    return sValue;
+}
 
-            m_vecValueCache[i] = sValue;
+struct XMSRecordValueBlock {
+    typedef void result_type;
+
+    XModel_MSRecord *pModel;
+    XModel_MSRecord::VALUE_CACHE_BUILD *pBuild;
+    const uchar *pMapped;
+    qint64 nFileSize;
+    QAtomicInt *pProgress;
+    qint32 nTotal;
+
+    void operator()(const QPair<qint32, qint32> &block) const
+    {
+        // read_msRecordString needs a device: every block gets its own buffer over the mapping
+        QByteArray baMapped;
+        QBuffer buffer;
+
+        if (pModel->m_valueType == XBinary::VT_STRING) {
+            baMapped = QByteArray::fromRawData((const char *)pMapped, (qint32)nFileSize);
+            buffer.setBuffer(&baMapped);
+            buffer.open(QIODevice::ReadOnly);
         }
 
+        XBinary binary(&buffer);
+        QString *pValues = pBuild->vecValues.data();
+
+        for (qint32 i = block.first; i < block.second; i++) {
+            if (pModel->m_nValueCacheCancel.loadAcquire()) {
+                return;
+            }
+
+            pValues[i] = pModel->_decodeMappedValue(i, pMapped, nFileSize, &binary);
+        }
+
+        pModel->_publishValues(pBuild, block.first, block.second - block.first);
+
+        qint32 nValue = pProgress->fetchAndAddOrdered(block.second - block.first) + (block.second - block.first);
+
+        emit pModel->valueCacheProgress(nValue, nTotal);
+    }
+};
+
+void XModel_MSRecord::buildValueCache()
+{
+    if (m_pValueCacheWatcher) {
+        return;  // Already running
+    }
+
+    qint32 nRowCount = m_pListRecords->count();
+    m_nValueCacheCancel.storeRelease(0);
+
+    VALUE_CACHE_BUILD *pBuild = new VALUE_CACHE_BUILD;
+    pBuild->vecValues.resize(nRowCount);
+    pBuild->baReady.resize(nRowCount);
+    pBuild->bReadyScheduled = false;
+    pBuild->pool.nSize = 0;
+
+    {
+        QMutexLocker locker(&m_valueCacheMutex);
+        m_pValueCacheBuild = pBuild;
+    }
+
+    m_pValueCacheWatcher = new QFutureWatcher<void>(this);
+    connect(m_pValueCacheWatcher, SIGNAL(finished()), this, SLOT(_onValueCacheFinished()));
+    m_pValueCacheWatcher->setFuture(QtConcurrent::run(_valueCacheThread, this, pBuild));
+}
+
+void XModel_MSRecord::waitForValueCache()
+{
+    if (m_pValueCacheWatcher) {
+        m_pValueCacheWatcher->waitForFinished();
+        _onValueCacheFinished();
+    }
+}
+
+bool XModel_MSRecord::isValueCacheBuilding() const
+{
+    return (m_pValueCacheWatcher != nullptr);
+}
+
+void XModel_MSRecord::_stopValueCache()
+{
+    cancelValueCache();
+    waitForValueCache();
+}
+
+void XModel_MSRecord::_valueCacheThread(XModel_MSRecord *pModel, VALUE_CACHE_BUILD *pBuild)
+{
+    pModel->_decodeValues(pBuild);
+
+    if (!pModel->m_nValueCacheCancel.loadAcquire()) {
+        _internValues(&pBuild->pool, pBuild->vecValues);
+    }
+}
+
+void XModel_MSRecord::_decodeValues(VALUE_CACHE_BUILD *pBuild)
+{
+    // Runs on the thread pool: the setters stop the build before they change the records or the value settings
+    qint32 nRowCount = pBuild->vecValues.count();
+    QString *pValues = pBuild->vecValues.data();
+
+    if (m_pValueStoreMapped) {
+        // The values are cached on disk: read them back from the store, not from the device
+        for (qint32 i = 0; (i < nRowCount) && !m_nValueCacheCancel.loadAcquire(); i++) {
+            pValues[i] = _readValueFromStore(i);
+        }
+
+        return;
+    }
+
+    if (!m_pDevice) {
+        return;
+    }
+
+    // Try memory mapping for fast access (avoids per-byte I/O). The mapping is made on a private QFile:
+    // the mapping table of the shared device is not thread-safe and the device belongs to the caller
+    QFile *pFile = _openPrivateFile();
+    uchar *pMapped = nullptr;
+    qint64 nFileSize = 0;
+
+    if (pFile) {
+        nFileSize = pFile->size();
+
+        if (nFileSize > 0) {
+            pMapped = pFile->map(0, nFileSize);
+        }
+    }
+
+    if (pMapped && (m_valueType == XBinary::VT_STRING) && (nFileSize > std::numeric_limits<int>::max())) {
+        // VT_STRING is decoded by XBinary over an in-memory view of the mapping; too large for a QByteArray here
+        pFile->unmap(pMapped);
+        pMapped = nullptr;
+    }
+
+    if (pMapped) {
+        // Row blocks are decoded in parallel from the shared read-only mapping; each block writes its own slice
+        QVector<QPair<qint32, qint32>> vecBlocks;
+
+        for (qint32 i = 0; i < nRowCount; i += N_VALUECACHE_BLOCK) {
+            vecBlocks.append(qMakePair(i, qMin(i + N_VALUECACHE_BLOCK, nRowCount)));
+        }
+
+        QAtomicInt nProgress;
+
+        XMSRecordValueBlock functorBlock;
+        functorBlock.pModel = this;
+        functorBlock.pBuild = pBuild;
+        functorBlock.pMapped = pMapped;
+        functorBlock.nFileSize = nFileSize;
+        functorBlock.pProgress = &nProgress;
+        functorBlock.nTotal = nRowCount;
+
+        QtConcurrent::blockingMap(vecBlocks, functorBlock);
+
         pFile->unmap(pMapped);
     } else {
-        // Fallback to original per-byte I/O for non-file QIODevice
-        XBinary binary(m_pDevice);
+        // Non-file QIODevice: the records read from the device are visited in file offset order,
+        // a block at a time, so every block is a few coalesced sequential reads
+        QVector<qint32> vecDeviceRows;
+        QVector<quint64> vecOffsets;
 
         for (qint32 i = 0; i < nRowCount; i++) {
-            QString sValue;
-
             if (!m_pListRecords->at(i).sValue.isEmpty()) {
-                sValue = m_pListRecords->at(i).sValue;
+                pValues[i] = m_pListRecords->at(i).sValue;
             } else if ((m_valueType == XBinary::VT_STRING) || (m_valueType == XBinary::VT_A_I) || (m_valueType == XBinary::VT_U_I) || (m_valueType == XBinary::VT_UTF8_I)) {
-                const XBinary::MS_RECORD &record = m_pListRecords->at(i);
-                XBinary::VT valueType = m_valueType;
-
-                if (m_valueType == XBinary::VT_STRING) {
-                    valueType = (XBinary::VT)record.nValueType;
-                }
-
-                qint64 nRecordOffset = -1;
-                if (getMSRecordOffset(m_memoryMap, record, &nRecordOffset)) {
-                    if (m_valueType == XBinary::VT_STRING) {
-                        sValue = binary.read_msRecordString(record, nRecordOffset);
-                    } else {
-                        XBinary::MS_RECORD fixedTypeRecord = record;
-                        fixedTypeRecord.nValueType = valueType;
-                        fixedTypeRecord.nInfo = (m_endian == XBinary::ENDIAN_BIG) ? XBinary::ENDIAN_BIG : XBinary::ENDIAN_LITTLE;
-                        sValue = binary.read_msRecordString(fixedTypeRecord, nRecordOffset);
-                    }
-                }
+                vecDeviceRows.append(i);
+                vecOffsets.append(_getRawSortKey(i, COLUMN_OFFSET));
             } else if (m_valueType == XBinary::VT_SIGNATURE) {
                 if (m_pListSignatureRecords && (m_pListSignatureRecords->count() > m_pListRecords->at(i).nInfo)) {
-                    sValue = m_pListSignatureRecords->at(m_pListRecords->at(i).nInfo).sName;
+                    pValues[i] = m_pListSignatureRecords->at(m_pListRecords->at(i).nInfo).sName;
                 } else {
-                    sValue = m_sValue;
+                    pValues[i] = m_sValue;
                 }
             } else {
-                sValue = m_sValue;
+                pValues[i] = m_sValue;
             }
+        }
 
-            m_vecValueCache[i] = sValue;
+        qint32 nNumberOfDeviceRows = vecDeviceRows.count();
+        QVector<qint32> vecOrder = getSortPermutation(vecOffsets, Qt::AscendingOrder);
+        QVector<qint32> vecBlockRows;
+        QVector<QString> vecBlockValues;
+
+        for (qint32 i = 0; (i < nNumberOfDeviceRows) && !m_nValueCacheCancel.loadAcquire(); i += N_VALUECACHE_BLOCK) {
+            qint32 nBlockSize = qMin(N_VALUECACHE_BLOCK, nNumberOfDeviceRows - i);
+            vecBlockRows.resize(nBlockSize);
+            vecBlockValues.fill(QString(), nBlockSize);
+
+            for (qint32 j = 0; j < nBlockSize; j++) {
+                vecBlockRows[j] = vecDeviceRows.at(vecOrder.at(i + j));
+            }
+
+            _readValuesFromDevice(pFile ? pFile : m_pDevice, vecBlockRows.constData(), nBlockSize, vecBlockValues.data());
+
+            for (qint32 j = 0; j < nBlockSize; j++) {
+                pValues[vecBlockRows.at(j)] = vecBlockValues.at(j);
+            }
+
+            _publishValues(pBuild, 0, nBlockSize, vecBlockRows.constData());
+
+            emit valueCacheProgress(i + nBlockSize, nNumberOfDeviceRows);
         }
     }
 
-    m_bValueCacheValid = true;
+    delete pFile;
+}
+
+void XModel_MSRecord::_publishValues(VALUE_CACHE_BUILD *pBuild, qint32 nFirst, qint32 nCount, const qint32 *pRows)
+{
+    bool bSchedule = false;
+
+    {
+        QMutexLocker locker(&m_valueCacheMutex);
+
+        for (qint32 i = 0; i < nCount; i++) {
+            pBuild->baReady.setBit(pRows ? pRows[i] : (nFirst + i));
+        }
+
+        bSchedule = !pBuild->bReadyScheduled;
+        pBuild->bReadyScheduled = true;
+    }
+
+    if (bSchedule) {
+        QMetaObject::invokeMethod(this, "_onValueCacheBlocksReady", Qt::QueuedConnection);
+    }
+}
+
+bool XModel_MSRecord::_getPublishedValue(qint32 nDataRow, QString *pValue) const
+{
+    QMutexLocker locker(&m_valueCacheMutex);
+
+    if (m_pValueCacheBuild && (nDataRow < m_pValueCacheBuild->baReady.size()) && m_pValueCacheBuild->baReady.testBit(nDataRow)) {
+        *pValue = m_pValueCacheBuild->vecValues.at(nDataRow);
+
+        return true;
+    }
+
+    return false;
+}
+
+void XModel_MSRecord::_onValueCacheBlocksReady()
+{
+    {
+        QMutexLocker locker(&m_valueCacheMutex);
+
+        if (!m_pValueCacheBuild) {
+            return;
+        }
+
+        m_pValueCacheBuild->bReadyScheduled = false;
+    }
+
+    qint32 nRowCount = rowCount();
+
+    if (nRowCount > 0) {
+        // The records of a block are scattered in the sort order: the column is refreshed, the views repaint the visible rows only.
+        // The values were already shown or read on demand: not a content change for the filter and sort results.
+        emit dataChanged(index(0, COLUMN_VALUE), index(nRowCount - 1, COLUMN_VALUE), QVector<int>() << (Qt::UserRole + XModel::USERROLE_FETCHED));
+    }
+}
+
+void XModel_MSRecord::_onValueCacheFinished()
+{
+    if (!m_pValueCacheWatcher) {
+        return;  // Already installed by waitForValueCache()
+    }
+
+    disconnect(m_pValueCacheWatcher, nullptr, this, nullptr);
+    m_pValueCacheWatcher->deleteLater();
+    m_pValueCacheWatcher = nullptr;
+
+    VALUE_CACHE_BUILD *pBuild = nullptr;
+
+    {
+        QMutexLocker locker(&m_valueCacheMutex);
+        pBuild = m_pValueCacheBuild;
+        m_pValueCacheBuild = nullptr;
+    }
+
+    bool bValid = !m_nValueCacheCancel.loadAcquire();
+
+    if (bValid) {
+        m_valuePool = pBuild->pool;
+        m_bValueCacheValid = true;
+    }
+
+    delete pBuild;
+
+    emit valueCacheFinished(bValid);
+}
+
+void XModel_MSRecord::_internValues(VALUE_POOL *pPool, const QVector<QString> &vecValues)
+{
+    // Search results repeat the same strings: every distinct value is kept once, the rows hold 32-bit ids
+    qint32 nRowCount = vecValues.count();
+
+    pPool->vecIds.resize(nRowCount);
+    pPool->vecValues.clear();
+    pPool->hashIds.clear();
+    pPool->nSize = nRowCount * (qint64)sizeof(quint32);
+
+    for (qint32 i = 0; i < nRowCount; i++) {
+        pPool->vecIds[i] = _internValue(pPool, vecValues.at(i));
+    }
+}
+
+quint32 XModel_MSRecord::_internValue(VALUE_POOL *pPool, const QString &sValue)
+{
+    QHash<QString, quint32>::const_iterator iter = pPool->hashIds.constFind(sValue);
+
+    if (iter != pPool->hashIds.constEnd()) {
+        return iter.value();
+    }
+
+    quint32 nId = pPool->vecValues.count();
+    pPool->vecValues.append(sValue);
+    pPool->hashIds.insert(sValue, nId);  // Shares the string with the pool: only the node is extra
+    pPool->nSize += N_STRING_OVERHEAD + N_HASH_NODE_OVERHEAD + sValue.size() * (qint64)sizeof(QChar);
+
+    return nId;
+}
+
+bool XModel_MSRecord::getColumnValueIds(qint32 nColumn, QVector<quint32> *pVecIds, QVector<QString> *pVecValues) const
+{
+    if ((nColumn != COLUMN_VALUE) || !m_bValueCacheValid) {
+        return false;
+    }
+
+    qint32 nRowCount = m_vecSortIndex.count();
+    pVecIds->resize(nRowCount);
+
+    for (qint32 i = 0; i < nRowCount; i++) {
+        (*pVecIds)[i] = m_valuePool.vecIds.at(m_vecSortIndex.at(i));
+    }
+
+    *pVecValues = m_valuePool.vecValues;
+
+    return true;
+}
+
+void XModel_MSRecord::cancelValueCache()
+{
+    m_nValueCacheCancel.storeRelease(1);
 }
 
 void XModel_MSRecord::clearValueCache()
 {
-    m_vecValueCache.clear();
+    _stopValueCache();
+
+    m_valuePool.vecIds.clear();
+    m_valuePool.vecValues.clear();
+    m_valuePool.hashIds.clear();
     m_bValueCacheValid = false;
+    m_valuePool.nSize = 0;
+}
+
+qint64 XModel_MSRecord::getResidentSize() const
+{
+    // The records belong to the caller: their values count only when releaseMemory() may spill them
+    if (m_bSpillOnRelease && (m_nRecordValuesSize == -1)) {
+        // Values kept in the records themselves (search strings); recounted after they change
+        m_nRecordValuesSize = 0;
+        qint32 nRowCount = m_pListRecords->count();
+
+        for (qint32 i = 0; i < nRowCount; i++) {
+            const QString &sValue = m_pListRecords->at(i).sValue;
+
+            if (!sValue.isEmpty()) {
+                m_nRecordValuesSize += N_STRING_OVERHEAD + sValue.size() * (qint64)sizeof(QChar);
+            }
+        }
+    }
+
+    qint64 nPermutationsSize = 0;
+
+    for (qint32 i = 0; i < m_listSortPermutations.count(); i++) {
+        nPermutationsSize += m_listSortPermutations.at(i).vecIndex.size() * (qint64)sizeof(qint32);
+    }
+
+    // The sort index and the disk store index are needed to show the rows: not counted, releaseMemory() keeps them
+    return XModel::getResidentSize() + m_valuePool.nSize + (m_bSpillOnRelease ? m_nRecordValuesSize : 0) + nPermutationsSize;
+}
+
+void XModel_MSRecord::releaseMemory()
+{
+    XModel::releaseMemory();
+
+    m_listSortPermutations.clear();
+
+    // The value cache is rebuilt by the next value sort
+    clearValueCache();
+
+    if (m_bSpillOnRelease) {
+        // The owner of the records allowed it: the values come back from the disk store on access
+        spillValuesToDisk();
+    }
 }
 
 bool XModel_MSRecord::isValueCacheValid() const
@@ -742,8 +1713,10 @@ bool XModel_MSRecord::isValueCacheValid() const
     return m_bValueCacheValid;
 }
 
-bool XModel_MSRecord::spillValuesToDisk()
+bool XModel_MSRecord::spillValuesToDisk(bool bDeduplicate)
 {
+    _stopValueCache();  // The decode threads read m_pValueStoreMapped
+
     if (m_pValueStoreMapped) {
         return true;  // Already spilled
     }
@@ -773,11 +1746,29 @@ bool XModel_MSRecord::spillValuesToDisk()
     qint64 nCurrentOffset = 0;
     QByteArray baBuffer;
     const qint32 N_BUFFER_LIMIT = 0x400000;  // Flush in 4 MiB chunks
+    const qint32 N_DEDUP_LIMIT = 0x100000;   // Unique values remembered for deduplication; bounds the RAM used while spilling
+    QHash<QByteArray, quint64> hashUniqueValues;
 
     for (qint32 i = 0; i < nRowCount; i++) {
         QByteArray baValue = m_pListRecords->at(i).sValue.toUtf8();
         qint32 nLength = qMin(baValue.size(), (qint32)0xFFFFFF);  // 24 bits for the length
 
+        if (bDeduplicate && (nLength > 0)) {
+            // Search results repeat the same names and paths: equal values share one copy in the store
+            baValue.truncate(nLength);
+
+            QHash<QByteArray, quint64>::const_iterator iter = hashUniqueValues.constFind(baValue);
+
+            if (iter != hashUniqueValues.constEnd()) {
+                m_vecValueStoreIndex[i] = iter.value();
+                continue;
+            }
+
+            if (hashUniqueValues.count() < N_DEDUP_LIMIT) {
+                hashUniqueValues.insert(baValue, ((quint64)nCurrentOffset << 24) | (quint64)nLength);
+            }
+        }
+
         m_vecValueStoreIndex[i] = ((quint64)nCurrentOffset << 24) | (quint64)nLength;
 
         baBuffer.append(baValue.constData(), nLength);
@@ -820,6 +1811,8 @@ bool XModel_MSRecord::spillValuesToDisk()
         (*m_pListRecords)[i].sValue = QString();
     }
 
+    m_nRecordValuesSize = 0;
+
     clearValueCache();
 
     return true;
@@ -26,6 +26,12 @@
 #include "xmodel.h"
 #include <algorithm>
 
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QSet>
 #include <QTemporaryFile>
 
 class XModel_MSRecord : public XModel {
@@ -62,16 +68,98 @@ public:
     virtual bool hasSortKeyHex() const;
     virtual quint64 getSortKeyHex(qint32 nRow, qint32 nColumn) const;
     virtual void sortByColumn(qint32 nColumn, Qt::SortOrder order);
+    virtual void sortByColumns(const QList<SORT_COLUMN> &listColumns);
+    // COLUMN_VALUE needs the value cache or the disk store: buildValueCache() first
+    virtual bool computeRowOrder(const QList<SORT_COLUMN> &listColumns, QVector<qint32> *pVecRowOrder, QAtomicInt *pCancelFlag = nullptr) const;
+    virtual void applyRowOrder(const QVector<qint32> &vecRowOrder);
+    virtual bool getColumnValueIds(qint32 nColumn, QVector<quint32> *pVecIds, QVector<QString> *pVecValues) const;
+    // Starts decoding the values in parallel row blocks on the thread pool; the values of the finished blocks are
+    // shown at once (dataChanged), the cache is installed on valueCacheFinished(). See cancelValueCache().
     void buildValueCache();
+    void waitForValueCache();  // Blocks until a running buildValueCache() is done and its cache installed
+    bool isValueCacheBuilding() const;
+    void cancelValueCache();  // Thread-safe: stops a running buildValueCache(), the cache stays invalid
     void clearValueCache();
     bool isValueCacheValid() const;
-    bool spillValuesToDisk();  // Move string values to a memory-mapped temp file to reduce RAM usage; the model reads them back on demand
+    bool spillValuesToDisk(bool bDeduplicate = true);  // Move string values to a memory-mapped temp file to reduce RAM usage; the model reads them back on demand
     bool isValueStoreActive() const;
+    virtual qint64 getResidentSize() const;
+    virtual void prepareForDeferredDelete();
+    virtual void releaseMemory();  // Drops the value cache and the sort permutations; spills the values only if enabled below
+    // Opt-in: under memory pressure the values of the records are moved to the disk store and cleared in
+    // the caller's list. Only for owners that read the values back through the model.
+    void setSpillOnReleaseEnabled(bool bEnabled);
+    bool isSpillOnReleaseEnabled() const;
+
+    // Opt-in: values that would be read from the device on the GUI thread are shown as a placeholder and
+    // fetched by a worker in file offset order; dataChanged follows per batch. Bulk access reads directly.
+    // Needs a device that is a named QFile (the worker opens its own handle); stays off otherwise.
+    void setLazyValuesEnabled(bool bEnabled);
+    bool isLazyValuesEnabled() const;
+
+signals:
+    void valueCacheProgress(qint32 nValue, qint32 nMaximum);  // Emitted from the decode threads
+    void valueCacheFinished(bool bValid);                     // bValid: the cache was built, false if canceled
+
+private slots:
+    void _startLazyFetch();
+    void _onLazyValuesReady();
+    void _onValueCacheBlocksReady();
+    void _onValueCacheFinished();
 
 private:
+    friend struct XMSRecordValueBlock;
+
+    virtual qint32 _getColumnSymbolHint(qint32 nColumn) const;
+    virtual void _applyPartialSortResult(const QVector<qint32> &vecIndex);
     void _init(const XBinary::_MEMORY_MAP &memoryMap, QVector<XBinary::MS_RECORD> *pListRecods, XBinary::VT valueType);
     quint64 _getRawSortKey(qint32 nDataRow, qint32 nColumn) const;
     QString _readValueFromStore(qint32 nDataRow) const;
+    struct VALUE_POOL {
+        QVector<quint32> vecIds;          // Per record an id into vecValues
+        QVector<QString> vecValues;       // Distinct values
+        QHash<QString, quint32> hashIds;  // Lookup of vecValues, kept for updateStringRecord()
+        qint64 nSize;
+    };
+
+    struct VALUE_CACHE_BUILD {
+        QVector<QString> vecValues;  // Per record; every decode block writes its own records only
+        QBitArray baReady;           // Records of the finished blocks; m_valueCacheMutex
+        bool bReadyScheduled;        // _onValueCacheBlocksReady() is queued; m_valueCacheMutex
+        VALUE_POOL pool;             // Interned by the worker at the end of the build
+    };
+
+    static void _internValues(VALUE_POOL *pPool, const QVector<QString> &vecValues);
+    static quint32 _internValue(VALUE_POOL *pPool, const QString &sValue);  // Id of the value in the pool, added if new; charged to nSize
+    static void _valueCacheThread(XModel_MSRecord *pModel, VALUE_CACHE_BUILD *pBuild);
+    void _decodeValues(VALUE_CACHE_BUILD *pBuild);
+    // The records of a finished block: pRows, or nCount records from nFirst if nullptr
+    void _publishValues(VALUE_CACHE_BUILD *pBuild, qint32 nFirst, qint32 nCount, const qint32 *pRows = nullptr);
+    bool _getPublishedValue(qint32 nDataRow, QString *pValue) const;
+    void _stopValueCache();  // The records or the value settings change next: no decode thread may read them anymore
+    QVector<quint64> _computeSortKeys(qint32 nColumn, QAtomicInt *pCancelFlag = nullptr) const;  // Per record; equal values get equal keys, empty if canceled
+    QVector<qint32> _computeSortPermutation(qint32 nColumn);
+    bool _findSortPermutation(qint32 nColumn, QVector<qint32> *pVecIndex);
+    void _addSortPermutation(qint32 nColumn, const QVector<qint32> &vecIndex);
+    void _invalidateDerivedValues();  // The values changed: computed sort orders and fetched values are stale
+    void _clearLazyRequests();        // Pending lazy requests carry the old model rows; the views ask again after layoutChanged
+    struct VALUE_READ {
+        qint32 nDataRow;
+        qint32 nRow;                 // Model row to report; -1: none
+        XBinary::MS_RECORD record;   // Copy: the GUI thread may update the record during the read
+        qint64 nOffset;              // -1: not in the file
+    };
+
+    QString _readValueFromDevice(XBinary *pBinary, qint32 nDataRow) const;
+    VALUE_READ _getValueRead(qint32 nDataRow) const;
+    QFile *_openPrivateFile() const;  // Own handle on the file of m_pDevice, nullptr if it is not a named QFile; the caller deletes it
+    void _readValuesFromDevice(QIODevice *pDevice, const qint32 *pRows, qint32 nCount, QString *pValues) const;  // Batched: pValues[i] for pRows[i]
+    // Reads only the requests and pDevice (m_pDevice is locked, a private device is not): usable from the lazy fetch worker
+    void _readValues(QIODevice *pDevice, const VALUE_READ *pRequests, qint32 nCount, XBinary::VT valueType, bool bBigEndian, QString *pValues) const;
+    QString _getLazyValue(qint32 nRow, qint32 nDataRow, bool *pbFetched) const;
+    static void _lazyFetchThread(XModel_MSRecord *pModel, const QVector<VALUE_READ> &vecRequests, XBinary::VT valueType, bool bBigEndian,
+                                 qint32 nGeneration);
+    QString _decodeMappedValue(qint32 nDataRow, const uchar *pMapped, qint64 nFileSize, XBinary *pBinary) const;
 
     XBinary::INDATA m_inData;
     QIODevice *m_pDevice;
@@ -85,9 +173,42 @@ private:
     XBinary::VT m_valueType;
     QString m_sValue;
     QList<XBinary::SIGNATUREDB_RECORD> *m_pListSignatureRecords;
-    QVector<QString> m_vecValueCache;
+    VALUE_POOL m_valuePool;  // Value cache
     bool m_bValueCacheValid;
+    QAtomicInt m_nValueCacheCancel;
+    QFutureWatcher<void> *m_pValueCacheWatcher;  // Running buildValueCache(), nullptr if none
+    VALUE_CACHE_BUILD *m_pValueCacheBuild;       // Set and cleared under m_valueCacheMutex: data() may run on the filter/sort threads
+    mutable QMutex m_valueCacheMutex;
+    mutable qint64 m_nRecordValuesSize;  // -1: not counted yet
     QVector<qint32> m_vecSortIndex;
+
+    struct SORT_PERMUTATION {
+        qint32 nColumn;
+        quint32 nGeneration;
+        QVector<qint32> vecIndex;  // Ascending order
+    };
+
+    QList<SORT_PERMUTATION> m_listSortPermutations;  // LRU, most recently used first
+    qint32 m_nPartialSortColumn;                      // Sort that the pending background permutation belongs to
+    Qt::SortOrder m_partialSortOrder;
+    quint32 m_nDataGeneration;
+
+    bool m_bLazyValues;
+    bool m_bSpillOnRelease;
+    mutable QMutex m_deviceMutex;  // Serializes m_pDevice reads between the GUI thread and the lazy fetch worker
+    mutable QMutex m_lazyMutex;    // Guards the lazy fetch state below
+    mutable QHash<qint32, QString> m_hashLazyValues;      // Fetched values by data row
+    mutable QSet<qint32> m_setLazyRequested;
+    mutable QList<QPair<qint32, qint32>> m_listLazyQueue;  // (data row, model row) not sent to the worker yet
+    mutable bool m_bLazyScheduled;
+    bool m_bLazyRunning;
+    qint32 m_nLazyGeneration;
+    QList<qint32> m_listLazyReady;  // Model rows fetched since the last dataChanged
+    QAtomicInt m_nLazyStop;
+    QFuture<void> m_lazyFuture;
+    QFile *m_pLazyFile;          // Private handle of the lazy fetch worker
+    QString m_sLazyPlaceholder;  // Shown until a value is fetched
+
     QTemporaryFile m_valueStoreFile;             // Disk cache with the UTF-8 encoded string values; removed automatically
     const uchar *m_pValueStoreMapped;            // Memory mapping of the store: immutable, safe for concurrent reads from the filter/sort threads
     QVector<quint64> m_vecValueStoreIndex;       // Packed per record: (nOffset << 24) | nUtf8Length
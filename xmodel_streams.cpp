@@ -20,6 +20,68 @@
  */
 #include "xmodel_streams.h"
 
+namespace {
+QVariant _getName(const XBinary::FPART &record)
+{
+    return record.sName;
+}
+
+QVariant _getOffset(const XBinary::FPART &record)
+{
+    return QString::number(record.nFileOffset, 16);
+}
+
+quint64 _getOffsetKey(const XBinary::FPART &record)
+{
+    return XModel::getSignedSortKey(record.nFileOffset);
+}
+
+QVariant _getSize(const XBinary::FPART &record)
+{
+    return QString::number(record.nFileSize, 16);
+}
+
+quint64 _getSizeKey(const XBinary::FPART &record)
+{
+    return XModel::getSignedSortKey(record.nFileSize);
+}
+
+QVariant _getCompressMethod(const XBinary::FPART &record)
+{
+    return record.mapProperties.contains(XBinary::FPART_PROP_HANDLEMETHOD) ? QVariant(XBinary::getHandleMethods(record.mapProperties)) : QVariant();
+}
+
+QVariant _getUncompressedSize(const XBinary::FPART &record)
+{
+    QVariant result;
+
+    if (record.mapProperties.contains(XBinary::FPART_PROP_UNCOMPRESSEDSIZE)) {
+        result = QString::number(record.mapProperties.value(XBinary::FPART_PROP_UNCOMPRESSEDSIZE).toULongLong(), 16);
+    }
+
+    return result;
+}
+
+quint64 _getUncompressedSizeKey(const XBinary::FPART &record)
+{
+    quint64 nResult = 0;  // Unknown size: empty cells first
+
+    if (record.mapProperties.contains(XBinary::FPART_PROP_UNCOMPRESSEDSIZE)) {
+        nResult = record.mapProperties.value(XBinary::FPART_PROP_UNCOMPRESSEDSIZE).toULongLong() + 1;
+    }
+
+    return nResult;
+}
+
+const XModelColumns<XBinary::FPART>::COLUMN g_columns[XModel_Streams::__COLUMN_COUNT] = {
+    {QT_TRANSLATE_NOOP("QObject", "Name"), Qt::AlignVCenter | Qt::AlignLeft, 20, XModel::SORT_KEY_TEXT, _getName, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Offset"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getOffset, _getOffsetKey},
+    {QT_TRANSLATE_NOOP("QObject", "Size"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getSize, _getSizeKey},
+    {QT_TRANSLATE_NOOP("QObject", "Compress"), Qt::AlignVCenter | Qt::AlignLeft, 10, XModel::SORT_KEY_TEXT, _getCompressMethod, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "U.Size"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getUncompressedSize, _getUncompressedSizeKey},
+};
+}  // namespace
+
 XModel_Streams::XModel_Streams(QList<XBinary::FPART> *pListFParts, QObject *pParent) : XModel(pParent)
 {
     m_pListFParts = pListFParts;
@@ -34,23 +96,7 @@ XModel_Streams::XModel_Streams(QList<XBinary::FPART> *pListFParts, QObject *pPar
 
 void XModel_Streams::_initColumns()
 {
-    setColumnName(COLUMN_NAME, QObject::tr("Name"));
-    setColumnName(COLUMN_OFFSET, QObject::tr("Offset"));
-    setColumnName(COLUMN_SIZE, QObject::tr("Size"));
-    setColumnName(COLUMN_COMPRESSMETHOD, QObject::tr("Compress"));
-    setColumnName(COLUMN_UNCOMPRESSEDSIZE, QObject::tr("U.Size"));
-
-    setColumnAlignment(COLUMN_NAME, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_OFFSET, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_SIZE, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_COMPRESSMETHOD, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_UNCOMPRESSEDSIZE, Qt::AlignVCenter | Qt::AlignRight);
-
-    setColumnSymbolSize(COLUMN_NAME, 20);
-    setColumnSymbolSize(COLUMN_OFFSET, 16);
-    setColumnSymbolSize(COLUMN_SIZE, 16);
-    setColumnSymbolSize(COLUMN_COMPRESSMETHOD, 10);
-    setColumnSymbolSize(COLUMN_UNCOMPRESSEDSIZE, 16);
+    XModelColumns<XBinary::FPART>::init(this, g_columns, __COLUMN_COUNT);
 }
 
 QVariant XModel_Streams::data(const QModelIndex &index, int nRole) const
@@ -65,29 +111,15 @@ QVariant XModel_Streams::data(const QModelIndex &index, int nRole) const
         qint32 nRow = index.row();
         if (nRow >= 0 && nRow < m_pListFParts->count()) {
             qint32 nColumn = index.column();
-            const XBinary::FPART &rec = m_pListFParts->at(nRow);
+            qint32 nDataRow = _getDataRow(nRow);
+            const XBinary::FPART &rec = m_pListFParts->at(nDataRow);
             if (nRole == Qt::DisplayRole) {
-                if (nColumn == COLUMN_NAME) {
-                    result = rec.sName;
-                } else if (nColumn == COLUMN_OFFSET) {
-                    result = QString::number(rec.nFileOffset, 16);
-                } else if (nColumn == COLUMN_SIZE) {
-                    result = QString::number(rec.nFileSize, 16);
-                } else if (nColumn == COLUMN_COMPRESSMETHOD) {
-                    if (rec.mapProperties.contains(XBinary::FPART_PROP_HANDLEMETHOD)) {
-                        result = XBinary::getHandleMethods(rec.mapProperties);
-                    }
-                } else if (nColumn == COLUMN_UNCOMPRESSEDSIZE) {
-                    if (rec.mapProperties.contains(XBinary::FPART_PROP_UNCOMPRESSEDSIZE)) {
-                        quint64 nUSz = rec.mapProperties.value(XBinary::FPART_PROP_UNCOMPRESSEDSIZE).toULongLong();
-                        result = QString::number(nUSz, 16);
-                    }
-                }
+                result = XModelColumns<XBinary::FPART>::getDisplay(g_columns, __COLUMN_COUNT, rec, nColumn);
             } else if (nRole == Qt::TextAlignmentRole) {
                 result = getColumnAlignment(nColumn);
             } else if (nRole >= Qt::UserRole) {
                 if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
-                    result = nRow;
+                    result = nDataRow;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_OFFSET)) {
                     result = rec.nFileOffset;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
@@ -116,3 +148,13 @@ QVariant XModel_Streams::headerData(int nSection, Qt::Orientation orientation, i
 
     return result;
 }
+
+quint64 XModel_Streams::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
+{
+    return XModelColumns<XBinary::FPART>::getSortKey(g_columns, __COLUMN_COUNT, m_pListFParts->at(nDataRow), nColumn);
+}
+
+QString XModel_Streams::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
+{
+    return XModelColumns<XBinary::FPART>::getText(g_columns, __COLUMN_COUNT, m_pListFParts->at(nDataRow), nColumn);
+}
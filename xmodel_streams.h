@@ -42,6 +42,10 @@ public:
     QVariant data(const QModelIndex &index, int nRole = Qt::DisplayRole) const override;
     QVariant headerData(int nSection, Qt::Orientation orientation, int nRole = Qt::DisplayRole) const override;
 
+protected:
+    virtual quint64 _getSortColumnKey(qint32 nDataRow, qint32 nColumn) const override;
+    virtual QString _getSortColumnText(qint32 nDataRow, qint32 nColumn) const override;
+
 private:
     QList<XBinary::FPART> *m_pListFParts;
     void _initColumns();
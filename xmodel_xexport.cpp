@@ -20,6 +20,50 @@
  */
 #include "xmodel_xexport.h"
 
+namespace {
+QVariant _getFunction(const XBinary::XEXPORT_STRUCT &record)
+{
+    return record.sFunction;
+}
+
+QVariant _getOrdinal(const XBinary::XEXPORT_STRUCT &record)
+{
+    return (record.nOrdinal >= 0) ? QVariant(record.nOrdinal) : QVariant();
+}
+
+quint64 _getOrdinalKey(const XBinary::XEXPORT_STRUCT &record)
+{
+    return (record.nOrdinal >= 0) ? ((quint64)record.nOrdinal + 1) : 0;  // No ordinal: empty cells first
+}
+
+QVariant _getOffset(const XBinary::XEXPORT_STRUCT &record)
+{
+    return QString::number(record.nOffset, 16);
+}
+
+quint64 _getOffsetKey(const XBinary::XEXPORT_STRUCT &record)
+{
+    return XModel::getSignedSortKey(record.nOffset);
+}
+
+QVariant _getAddress(const XBinary::XEXPORT_STRUCT &record)
+{
+    return QString::number(record.nAddress, 16);
+}
+
+quint64 _getAddressKey(const XBinary::XEXPORT_STRUCT &record)
+{
+    return (quint64)record.nAddress;
+}
+
+const XModelColumns<XBinary::XEXPORT_STRUCT>::COLUMN g_columns[XModel_XExport::__COLUMN_COUNT] = {
+    {QT_TRANSLATE_NOOP("QObject", "Function"), Qt::AlignVCenter | Qt::AlignLeft, 30, XModel::SORT_KEY_TEXT, _getFunction, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Ordinal"), Qt::AlignVCenter | Qt::AlignRight, 8, XModel::SORT_KEY_NUMBER, _getOrdinal, _getOrdinalKey},
+    {QT_TRANSLATE_NOOP("QObject", "Offset"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getOffset, _getOffsetKey},
+    {QT_TRANSLATE_NOOP("QObject", "Address"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getAddress, _getAddressKey},
+};
+}  // namespace
+
 XModel_XExport::XModel_XExport(QVector<XBinary::XEXPORT_STRUCT> *pListExports, QObject *pParent) : XModel(pParent)
 {
     m_pListExports = pListExports;
@@ -34,20 +78,7 @@ XModel_XExport::XModel_XExport(QVector<XBinary::XEXPORT_STRUCT> *pListExports, Q
 
 void XModel_XExport::_initColumns()
 {
-    setColumnName(COLUMN_FUNCTION, QObject::tr("Function"));
-    setColumnName(COLUMN_ORDINAL, QObject::tr("Ordinal"));
-    setColumnName(COLUMN_OFFSET, QObject::tr("Offset"));
-    setColumnName(COLUMN_ADDRESS, QObject::tr("Address"));
-
-    setColumnAlignment(COLUMN_FUNCTION, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_ORDINAL, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_OFFSET, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_ADDRESS, Qt::AlignVCenter | Qt::AlignRight);
-
-    setColumnSymbolSize(COLUMN_FUNCTION, 30);
-    setColumnSymbolSize(COLUMN_ORDINAL, 8);
-    setColumnSymbolSize(COLUMN_OFFSET, 16);
-    setColumnSymbolSize(COLUMN_ADDRESS, 16);
+    XModelColumns<XBinary::XEXPORT_STRUCT>::init(this, g_columns, __COLUMN_COUNT);
 }
 
 QVariant XModel_XExport::data(const QModelIndex &index, int nRole) const
@@ -62,24 +93,15 @@ QVariant XModel_XExport::data(const QModelIndex &index, int nRole) const
         qint32 nRow = index.row();
         if (nRow >= 0 && nRow < m_pListExports->count()) {
             qint32 nColumn = index.column();
-            const XBinary::XEXPORT_STRUCT &rec = m_pListExports->at(nRow);
+            qint32 nDataRow = _getDataRow(nRow);
+            const XBinary::XEXPORT_STRUCT &rec = m_pListExports->at(nDataRow);
             if (nRole == Qt::DisplayRole) {
-                if (nColumn == COLUMN_FUNCTION) {
-                    result = rec.sFunction;
-                } else if (nColumn == COLUMN_ORDINAL) {
-                    if (rec.nOrdinal >= 0) {
-                        result = rec.nOrdinal;
-                    }
-                } else if (nColumn == COLUMN_OFFSET) {
-                    result = QString::number(rec.nOffset, 16);
-                } else if (nColumn == COLUMN_ADDRESS) {
-                    result = QString::number(rec.nAddress, 16);
-                }
+                result = XModelColumns<XBinary::XEXPORT_STRUCT>::getDisplay(g_columns, __COLUMN_COUNT, rec, nColumn);
             } else if (nRole == Qt::TextAlignmentRole) {
                 result = getColumnAlignment(nColumn);
             } else if (nRole >= Qt::UserRole) {
                 if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
-                    result = nRow;
+                    result = nDataRow;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_OFFSET)) {
                     result = rec.nOffset;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
@@ -111,23 +133,17 @@ QVariant XModel_XExport::headerData(int nSection, Qt::Orientation orientation, i
     return result;
 }
 
-XModel::SORT_METHOD XModel_XExport::getSortMethod(qint32 nColumn)
+bool XModel_XExport::isCustomFilter()
 {
-    SORT_METHOD result = SORT_METHOD_DEFAULT;
-
-    if ((nColumn == COLUMN_OFFSET) || (nColumn == COLUMN_ADDRESS)) {
-        result = SORT_METHOD_HEX;
-    }
-
-    return result;
+    return false;
 }
 
-bool XModel_XExport::isCustomFilter()
+quint64 XModel_XExport::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XEXPORT_STRUCT>::getSortKey(g_columns, __COLUMN_COUNT, m_pListExports->at(nDataRow), nColumn);
 }
 
-bool XModel_XExport::isCustomSort()
+QString XModel_XExport::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XEXPORT_STRUCT>::getText(g_columns, __COLUMN_COUNT, m_pListExports->at(nDataRow), nColumn);
 }
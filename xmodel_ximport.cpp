@@ -20,6 +20,56 @@
  */
 #include "xmodel_ximport.h"
 
+namespace {
+QVariant _getLibrary(const XBinary::XIMPORT_STRUCT &record)
+{
+    return record.sLibrary;
+}
+
+QVariant _getFunction(const XBinary::XIMPORT_STRUCT &record)
+{
+    return record.sFunction;
+}
+
+QVariant _getOrdinal(const XBinary::XIMPORT_STRUCT &record)
+{
+    return (record.nOrdinal >= 0) ? QVariant(record.nOrdinal) : QVariant();
+}
+
+quint64 _getOrdinalKey(const XBinary::XIMPORT_STRUCT &record)
+{
+    return (record.nOrdinal >= 0) ? ((quint64)record.nOrdinal + 1) : 0;  // No ordinal: empty cells first
+}
+
+QVariant _getOffset(const XBinary::XIMPORT_STRUCT &record)
+{
+    return QString::number(record.nOffset, 16);
+}
+
+quint64 _getOffsetKey(const XBinary::XIMPORT_STRUCT &record)
+{
+    return XModel::getSignedSortKey(record.nOffset);
+}
+
+QVariant _getAddress(const XBinary::XIMPORT_STRUCT &record)
+{
+    return QString::number(record.nAddress, 16);
+}
+
+quint64 _getAddressKey(const XBinary::XIMPORT_STRUCT &record)
+{
+    return (quint64)record.nAddress;
+}
+
+const XModelColumns<XBinary::XIMPORT_STRUCT>::COLUMN g_columns[XModel_XImport::__COLUMN_COUNT] = {
+    {QT_TRANSLATE_NOOP("QObject", "Library"), Qt::AlignVCenter | Qt::AlignLeft, 20, XModel::SORT_KEY_TEXT, _getLibrary, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Function"), Qt::AlignVCenter | Qt::AlignLeft, 30, XModel::SORT_KEY_TEXT, _getFunction, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Ordinal"), Qt::AlignVCenter | Qt::AlignRight, 8, XModel::SORT_KEY_NUMBER, _getOrdinal, _getOrdinalKey},
+    {QT_TRANSLATE_NOOP("QObject", "Offset"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getOffset, _getOffsetKey},
+    {QT_TRANSLATE_NOOP("QObject", "Address"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getAddress, _getAddressKey},
+};
+}  // namespace
+
 XModel_XImport::XModel_XImport(QVector<XBinary::XIMPORT_STRUCT> *pListImports, QObject *pParent) : XModel(pParent)
 {
     m_pListImports = pListImports;
@@ -34,23 +84,7 @@ XModel_XImport::XModel_XImport(QVector<XBinary::XIMPORT_STRUCT> *pListImports, Q
 
 void XModel_XImport::_initColumns()
 {
-    setColumnName(COLUMN_LIBRARY, QObject::tr("Library"));
-    setColumnName(COLUMN_FUNCTION, QObject::tr("Function"));
-    setColumnName(COLUMN_ORDINAL, QObject::tr("Ordinal"));
-    setColumnName(COLUMN_OFFSET, QObject::tr("Offset"));
-    setColumnName(COLUMN_ADDRESS, QObject::tr("Address"));
-
-    setColumnAlignment(COLUMN_LIBRARY, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_FUNCTION, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_ORDINAL, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_OFFSET, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_ADDRESS, Qt::AlignVCenter | Qt::AlignRight);
-
-    setColumnSymbolSize(COLUMN_LIBRARY, 20);
-    setColumnSymbolSize(COLUMN_FUNCTION, 30);
-    setColumnSymbolSize(COLUMN_ORDINAL, 8);
-    setColumnSymbolSize(COLUMN_OFFSET, 16);
-    setColumnSymbolSize(COLUMN_ADDRESS, 16);
+    XModelColumns<XBinary::XIMPORT_STRUCT>::init(this, g_columns, __COLUMN_COUNT);
 }
 
 QVariant XModel_XImport::data(const QModelIndex &index, int nRole) const
@@ -65,26 +99,15 @@ QVariant XModel_XImport::data(const QModelIndex &index, int nRole) const
         qint32 nRow = index.row();
         if (nRow >= 0 && nRow < m_pListImports->count()) {
             qint32 nColumn = index.column();
-            const XBinary::XIMPORT_STRUCT &rec = m_pListImports->at(nRow);
+            qint32 nDataRow = _getDataRow(nRow);
+            const XBinary::XIMPORT_STRUCT &rec = m_pListImports->at(nDataRow);
             if (nRole == Qt::DisplayRole) {
-                if (nColumn == COLUMN_LIBRARY) {
-                    result = rec.sLibrary;
-                } else if (nColumn == COLUMN_FUNCTION) {
-                    result = rec.sFunction;
-                } else if (nColumn == COLUMN_ORDINAL) {
-                    if (rec.nOrdinal >= 0) {
-                        result = rec.nOrdinal;
-                    }
-                } else if (nColumn == COLUMN_OFFSET) {
-                    result = QString::number(rec.nOffset, 16);
-                } else if (nColumn == COLUMN_ADDRESS) {
-                    result = QString::number(rec.nAddress, 16);
-                }
+                result = XModelColumns<XBinary::XIMPORT_STRUCT>::getDisplay(g_columns, __COLUMN_COUNT, rec, nColumn);
             } else if (nRole == Qt::TextAlignmentRole) {
                 result = getColumnAlignment(nColumn);
             } else if (nRole >= Qt::UserRole) {
                 if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
-                    result = nRow;
+                    result = nDataRow;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_OFFSET)) {
                     result = rec.nOffset;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
@@ -118,23 +141,17 @@ QVariant XModel_XImport::headerData(int nSection, Qt::Orientation orientation, i
     return result;
 }
 
-XModel::SORT_METHOD XModel_XImport::getSortMethod(qint32 nColumn)
+bool XModel_XImport::isCustomFilter()
 {
-    SORT_METHOD result = SORT_METHOD_DEFAULT;
-
-    if ((nColumn == COLUMN_OFFSET) || (nColumn == COLUMN_ADDRESS)) {
-        result = SORT_METHOD_HEX;
-    }
-
-    return result;
+    return false;
 }
 
-bool XModel_XImport::isCustomFilter()
+quint64 XModel_XImport::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XIMPORT_STRUCT>::getSortKey(g_columns, __COLUMN_COUNT, m_pListImports->at(nDataRow), nColumn);
 }
 
-bool XModel_XImport::isCustomSort()
+QString XModel_XImport::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XIMPORT_STRUCT>::getText(g_columns, __COLUMN_COUNT, m_pListImports->at(nDataRow), nColumn);
 }
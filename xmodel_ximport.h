@@ -41,9 +41,11 @@ public:
 
     QVariant data(const QModelIndex &index, int nRole = Qt::DisplayRole) const override;
     QVariant headerData(int nSection, Qt::Orientation orientation, int nRole = Qt::DisplayRole) const override;
-    virtual SORT_METHOD getSortMethod(qint32 nColumn) override;
     virtual bool isCustomFilter() override;
-    virtual bool isCustomSort() override;
+
+protected:
+    virtual quint64 _getSortColumnKey(qint32 nDataRow, qint32 nColumn) const override;
+    virtual QString _getSortColumnText(qint32 nDataRow, qint32 nColumn) const override;
 
 private:
     QVector<XBinary::XIMPORT_STRUCT> *m_pListImports;
@@ -20,6 +20,72 @@
  */
 #include "xmodel_xresource.h"
 
+namespace {
+QVariant _getName(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return record.sName;
+}
+
+QVariant _getType(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return record.nType;
+}
+
+quint64 _getTypeKey(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return XModel::getSignedSortKey((qint64)record.nType);
+}
+
+QVariant _getID(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return record.nID;
+}
+
+quint64 _getIDKey(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return XModel::getSignedSortKey((qint64)record.nID);
+}
+
+QVariant _getOffset(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return QString::number(record.nOffset, 16);
+}
+
+quint64 _getOffsetKey(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return XModel::getSignedSortKey(record.nOffset);
+}
+
+QVariant _getSize(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return QString::number(record.nSize, 16);
+}
+
+quint64 _getSizeKey(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return XModel::getSignedSortKey(record.nSize);
+}
+
+QVariant _getAddress(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return (record.nAddress != (XADDR)-1) ? QVariant(QString::number(record.nAddress, 16)) : QVariant();
+}
+
+quint64 _getAddressKey(const XBinary::XRESOURCE_STRUCT &record)
+{
+    return (record.nAddress != (XADDR)-1) ? ((quint64)record.nAddress + 1) : 0;  // No address: empty cells first
+}
+
+const XModelColumns<XBinary::XRESOURCE_STRUCT>::COLUMN g_columns[XModel_XResource::__COLUMN_COUNT] = {
+    {QT_TRANSLATE_NOOP("QObject", "Name"), Qt::AlignVCenter | Qt::AlignLeft, 30, XModel::SORT_KEY_TEXT, _getName, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Type"), Qt::AlignVCenter | Qt::AlignRight, 10, XModel::SORT_KEY_NUMBER, _getType, _getTypeKey},
+    {QT_TRANSLATE_NOOP("QObject", "ID"), Qt::AlignVCenter | Qt::AlignRight, 10, XModel::SORT_KEY_NUMBER, _getID, _getIDKey},
+    {QT_TRANSLATE_NOOP("QObject", "Offset"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getOffset, _getOffsetKey},
+    {QT_TRANSLATE_NOOP("QObject", "Size"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getSize, _getSizeKey},
+    {QT_TRANSLATE_NOOP("QObject", "Address"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getAddress, _getAddressKey},
+};
+}  // namespace
+
 XModel_XResource::XModel_XResource(QVector<XBinary::XRESOURCE_STRUCT> *pListResources, QObject *pParent) : XModel(pParent)
 {
     m_pListResources = pListResources;
@@ -34,26 +100,7 @@ XModel_XResource::XModel_XResource(QVector<XBinary::XRESOURCE_STRUCT> *pListReso
 
 void XModel_XResource::_initColumns()
 {
-    setColumnName(COLUMN_NAME, QObject::tr("Name"));
-    setColumnName(COLUMN_TYPE, QObject::tr("Type"));
-    setColumnName(COLUMN_ID, QObject::tr("ID"));
-    setColumnName(COLUMN_OFFSET, QObject::tr("Offset"));
-    setColumnName(COLUMN_SIZE, QObject::tr("Size"));
-    setColumnName(COLUMN_ADDRESS, QObject::tr("Address"));
-
-    setColumnAlignment(COLUMN_NAME, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_TYPE, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_ID, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_OFFSET, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_SIZE, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_ADDRESS, Qt::AlignVCenter | Qt::AlignRight);
-
-    setColumnSymbolSize(COLUMN_NAME, 30);
-    setColumnSymbolSize(COLUMN_TYPE, 10);
-    setColumnSymbolSize(COLUMN_ID, 10);
-    setColumnSymbolSize(COLUMN_OFFSET, 16);
-    setColumnSymbolSize(COLUMN_SIZE, 16);
-    setColumnSymbolSize(COLUMN_ADDRESS, 16);
+    XModelColumns<XBinary::XRESOURCE_STRUCT>::init(this, g_columns, __COLUMN_COUNT);
 }
 
 QVariant XModel_XResource::data(const QModelIndex &index, int nRole) const
@@ -68,28 +115,15 @@ QVariant XModel_XResource::data(const QModelIndex &index, int nRole) const
         qint32 nRow = index.row();
         if (nRow >= 0 && nRow < m_pListResources->count()) {
             qint32 nColumn = index.column();
-            const XBinary::XRESOURCE_STRUCT &rec = m_pListResources->at(nRow);
+            qint32 nDataRow = _getDataRow(nRow);
+            const XBinary::XRESOURCE_STRUCT &rec = m_pListResources->at(nDataRow);
             if (nRole == Qt::DisplayRole) {
-                if (nColumn == COLUMN_NAME) {
-                    result = rec.sName;
-                } else if (nColumn == COLUMN_TYPE) {
-                    result = rec.nType;
-                } else if (nColumn == COLUMN_ID) {
-                    result = rec.nID;
-                } else if (nColumn == COLUMN_OFFSET) {
-                    result = QString::number(rec.nOffset, 16);
-                } else if (nColumn == COLUMN_SIZE) {
-                    result = QString::number(rec.nSize, 16);
-                } else if (nColumn == COLUMN_ADDRESS) {
-                    if (rec.nAddress != (XADDR)-1) {
-                        result = QString::number(rec.nAddress, 16);
-                    }
-                }
+                result = XModelColumns<XBinary::XRESOURCE_STRUCT>::getDisplay(g_columns, __COLUMN_COUNT, rec, nColumn);
             } else if (nRole == Qt::TextAlignmentRole) {
                 result = getColumnAlignment(nColumn);
             } else if (nRole >= Qt::UserRole) {
                 if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
-                    result = nRow;
+                    result = nDataRow;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_OFFSET)) {
                     result = rec.nOffset;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
@@ -121,23 +155,17 @@ QVariant XModel_XResource::headerData(int nSection, Qt::Orientation orientation,
     return result;
 }
 
-XModel::SORT_METHOD XModel_XResource::getSortMethod(qint32 nColumn)
+bool XModel_XResource::isCustomFilter()
 {
-    SORT_METHOD result = SORT_METHOD_DEFAULT;
-
-    if ((nColumn == COLUMN_OFFSET) || (nColumn == COLUMN_SIZE) || (nColumn == COLUMN_ADDRESS)) {
-        result = SORT_METHOD_HEX;
-    }
-
-    return result;
+    return false;
 }
 
-bool XModel_XResource::isCustomFilter()
+quint64 XModel_XResource::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XRESOURCE_STRUCT>::getSortKey(g_columns, __COLUMN_COUNT, m_pListResources->at(nDataRow), nColumn);
 }
 
-bool XModel_XResource::isCustomSort()
+QString XModel_XResource::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XRESOURCE_STRUCT>::getText(g_columns, __COLUMN_COUNT, m_pListResources->at(nDataRow), nColumn);
 }
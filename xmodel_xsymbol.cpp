@@ -20,6 +20,56 @@
  */
 #include "xmodel_xsymbol.h"
 
+namespace {
+QVariant _getName(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return record.sName;
+}
+
+QVariant _getType(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return XModel_XSymbol::symbolTypeToString(record.symbolType);
+}
+
+QVariant _getOffset(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return QString::number(record.nOffset, 16);
+}
+
+quint64 _getOffsetKey(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return XModel::getSignedSortKey(record.nOffset);
+}
+
+QVariant _getSize(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return QString::number(record.nSize, 16);
+}
+
+quint64 _getSizeKey(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return XModel::getSignedSortKey(record.nSize);
+}
+
+QVariant _getAddress(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return QString::number(record.nAddress, 16);
+}
+
+quint64 _getAddressKey(const XBinary::XSYMBOL_STRUCT &record)
+{
+    return (quint64)record.nAddress;
+}
+
+const XModelColumns<XBinary::XSYMBOL_STRUCT>::COLUMN g_columns[XModel_XSymbol::__COLUMN_COUNT] = {
+    {QT_TRANSLATE_NOOP("QObject", "Name"), Qt::AlignVCenter | Qt::AlignLeft, 30, XModel::SORT_KEY_TEXT, _getName, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Type"), Qt::AlignVCenter | Qt::AlignLeft, 12, XModel::SORT_KEY_TEXT, _getType, nullptr},
+    {QT_TRANSLATE_NOOP("QObject", "Offset"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getOffset, _getOffsetKey},
+    {QT_TRANSLATE_NOOP("QObject", "Size"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getSize, _getSizeKey},
+    {QT_TRANSLATE_NOOP("QObject", "Address"), Qt::AlignVCenter | Qt::AlignRight, 16, XModel::SORT_KEY_NUMBER, _getAddress, _getAddressKey},
+};
+}  // namespace
+
 XModel_XSymbol::XModel_XSymbol(QVector<XBinary::XSYMBOL_STRUCT> *pListSymbols, QObject *pParent) : XModel(pParent)
 {
     m_pListSymbols = pListSymbols;
@@ -34,23 +84,12 @@ XModel_XSymbol::XModel_XSymbol(QVector<XBinary::XSYMBOL_STRUCT> *pListSymbols, Q
 
 void XModel_XSymbol::_initColumns()
 {
-    setColumnName(COLUMN_NAME, QObject::tr("Name"));
-    setColumnName(COLUMN_TYPE, QObject::tr("Type"));
-    setColumnName(COLUMN_OFFSET, QObject::tr("Offset"));
-    setColumnName(COLUMN_SIZE, QObject::tr("Size"));
-    setColumnName(COLUMN_ADDRESS, QObject::tr("Address"));
+    XModelColumns<XBinary::XSYMBOL_STRUCT>::init(this, g_columns, __COLUMN_COUNT);
 
-    setColumnAlignment(COLUMN_NAME, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_TYPE, Qt::AlignVCenter | Qt::AlignLeft);
-    setColumnAlignment(COLUMN_OFFSET, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_SIZE, Qt::AlignVCenter | Qt::AlignRight);
-    setColumnAlignment(COLUMN_ADDRESS, Qt::AlignVCenter | Qt::AlignRight);
-
-    setColumnSymbolSize(COLUMN_NAME, 30);
-    setColumnSymbolSize(COLUMN_TYPE, 12);
-    setColumnSymbolSize(COLUMN_OFFSET, 16);
-    setColumnSymbolSize(COLUMN_SIZE, 16);
-    setColumnSymbolSize(COLUMN_ADDRESS, 16);
+    setColumnDisplayCache(COLUMN_TYPE, true);
+    setColumnDisplayCache(COLUMN_OFFSET, true);
+    setColumnDisplayCache(COLUMN_SIZE, true);
+    setColumnDisplayCache(COLUMN_ADDRESS, true);
 }
 
 QString XModel_XSymbol::symbolTypeToString(XBinary::SYMBOL_TYPE symbolType)
@@ -84,24 +123,19 @@ QVariant XModel_XSymbol::data(const QModelIndex &index, int nRole) const
         qint32 nRow = index.row();
         if (nRow >= 0 && nRow < m_pListSymbols->count()) {
             qint32 nColumn = index.column();
-            const XBinary::XSYMBOL_STRUCT &rec = m_pListSymbols->at(nRow);
+            qint32 nDataRow = _getDataRow(nRow);
+            const XBinary::XSYMBOL_STRUCT &rec = m_pListSymbols->at(nDataRow);
+            if ((nRole == Qt::DisplayRole) && _getDisplayCache(nRow, nColumn, &result)) {
+                return result;
+            }
             if (nRole == Qt::DisplayRole) {
-                if (nColumn == COLUMN_NAME) {
-                    result = rec.sName;
-                } else if (nColumn == COLUMN_TYPE) {
-                    result = symbolTypeToString(rec.symbolType);
-                } else if (nColumn == COLUMN_OFFSET) {
-                    result = QString::number(rec.nOffset, 16);
-                } else if (nColumn == COLUMN_SIZE) {
-                    result = QString::number(rec.nSize, 16);
-                } else if (nColumn == COLUMN_ADDRESS) {
-                    result = QString::number(rec.nAddress, 16);
-                }
+                result = XModelColumns<XBinary::XSYMBOL_STRUCT>::getDisplay(g_columns, __COLUMN_COUNT, rec, nColumn);
+                _setDisplayCache(nRow, nColumn, result);
             } else if (nRole == Qt::TextAlignmentRole) {
                 result = getColumnAlignment(nColumn);
             } else if (nRole >= Qt::UserRole) {
                 if (nRole == (Qt::UserRole + XModel::USERROLE_ORIGINDEX)) {
-                    result = nRow;
+                    result = nDataRow;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_OFFSET)) {
                     result = rec.nOffset;
                 } else if (nRole == (Qt::UserRole + XModel::USERROLE_SIZE)) {
@@ -135,23 +169,17 @@ QVariant XModel_XSymbol::headerData(int nSection, Qt::Orientation orientation, i
     return result;
 }
 
-XModel::SORT_METHOD XModel_XSymbol::getSortMethod(qint32 nColumn)
+bool XModel_XSymbol::isCustomFilter()
 {
-    SORT_METHOD result = SORT_METHOD_DEFAULT;
-
-    if ((nColumn == COLUMN_OFFSET) || (nColumn == COLUMN_SIZE) || (nColumn == COLUMN_ADDRESS)) {
-        result = SORT_METHOD_HEX;
-    }
-
-    return result;
+    return false;
 }
 
-bool XModel_XSymbol::isCustomFilter()
+quint64 XModel_XSymbol::_getSortColumnKey(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XSYMBOL_STRUCT>::getSortKey(g_columns, __COLUMN_COUNT, m_pListSymbols->at(nDataRow), nColumn);
 }
 
-bool XModel_XSymbol::isCustomSort()
+QString XModel_XSymbol::_getSortColumnText(qint32 nDataRow, qint32 nColumn) const
 {
-    return false;
+    return XModelColumns<XBinary::XSYMBOL_STRUCT>::getText(g_columns, __COLUMN_COUNT, m_pListSymbols->at(nDataRow), nColumn);
 }
@@ -21,7 +21,12 @@
 
 #include "xsortfilterproxymodel.h"
 
+#include <algorithm>
+#include <QtConcurrent>
+
 namespace {
+const qint32 N_FILTER_BLOCK = 0x4000;  // Rows per parallel filter block
+
 bool isNumericVariant(const QVariant &value)
 {
     switch (value.userType()) {
@@ -44,6 +49,75 @@ bool variantLessThan(const QVariant &left, const QVariant &right)
 
     return left.toString() < right.toString();
 }
+
+// Keeps the source model in bulk access for a whole cache pass: lazily fetched cells return real values
+struct XModelBulkAccess {
+    const XModel *pModel;
+
+    explicit XModelBulkAccess(const XModel *pModel) : pModel(pModel)
+    {
+        if (pModel) {
+            pModel->beginBulkAccess();
+        }
+    }
+
+    ~XModelBulkAccess()
+    {
+        if (pModel) {
+            pModel->endBulkAccess();
+        }
+    }
+};
+
+// Same order as variantLessThan() for two strings
+struct XSortFilterProxyModelValueLess {
+    const QVector<QString> *pValues;
+
+    bool operator()(qint32 nLeft, qint32 nRight) const
+    {
+        return pValues->at(nLeft) < pValues->at(nRight);
+    }
+};
+
+bool isSameSortColumns(const QList<XModel::SORT_COLUMN> &listLeft, const QList<XModel::SORT_COLUMN> &listRight)
+{
+    bool bResult = (listLeft.count() == listRight.count());
+
+    for (qint32 i = 0; bResult && (i < listLeft.count()); i++) {
+        bResult = (listLeft.at(i).nColumn == listRight.at(i).nColumn) && (listLeft.at(i).order == listRight.at(i).order);
+    }
+
+    return bResult;
+}
+
+// Dense ranks of the strings in the order of variantLessThan()
+QVector<quint64> getStringRanks(const QVector<QString> &vecValues)
+{
+    qint32 nNumberOfValues = vecValues.count();
+    QVector<qint32> vecOrder(nNumberOfValues);
+
+    for (qint32 i = 0; i < nNumberOfValues; i++) {
+        vecOrder[i] = i;
+    }
+
+    XSortFilterProxyModelValueLess functorLess;
+    functorLess.pValues = &vecValues;
+
+    std::sort(vecOrder.begin(), vecOrder.end(), functorLess);
+
+    QVector<quint64> vecResult(nNumberOfValues);
+    quint64 nRank = 0;
+
+    for (qint32 i = 0; i < nNumberOfValues; i++) {
+        if ((i > 0) && (vecValues.at(vecOrder.at(i)) != vecValues.at(vecOrder.at(i - 1)))) {
+            nRank++;
+        }
+
+        vecResult[vecOrder.at(i)] = nRank;
+    }
+
+    return vecResult;
+}
 }  // namespace
 
 XSortFilterProxyModel::XSortFilterProxyModel(QObject *pParent) : QSortFilterProxyModel(pParent)
@@ -56,6 +130,9 @@ XSortFilterProxyModel::XSortFilterProxyModel(QObject *pParent) : QSortFilterProx
     m_nSortCacheColumn = -1;
     m_sortCacheMethod = XModel::SORT_METHOD_DEFAULT;
     m_bFilterAcceptCacheValid = false;
+    m_nFilterEvaluatedRows = 0;
+    m_nProgressivePublished = 0;
+    m_bProgressivePrevValid = false;
 }
 
 void XSortFilterProxyModel::setFilters(const QList<QString> &listFilters)
@@ -63,6 +140,7 @@ void XSortFilterProxyModel::setFilters(const QList<QString> &listFilters)
 #if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
     beginFilterChange();
 #endif
+    _clearProgressiveFilter();
     m_listFilters = listFilters;
     clearFilterAcceptCache();
 #if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
@@ -81,6 +159,7 @@ void XSortFilterProxyModel::setColumnFilter(qint32 nColumn, const QString &sFilt
         m_listFilters.append(QString());
     }
 
+    _clearProgressiveFilter();
     m_listFilters[nColumn] = sFilter;
     clearFilterAcceptCache();
 #if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
@@ -90,6 +169,32 @@ void XSortFilterProxyModel::setColumnFilter(qint32 nColumn, const QString &sFilt
 #endif
 }
 
+void XSortFilterProxyModel::setFiltersRefined(const QList<QString> &listFilters)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    beginFilterChange();
+#endif
+    _clearProgressiveFilter();
+    m_listFilters = listFilters;
+    _updateFilterAcceptCache();
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    endFilterChange(QSortFilterProxyModel::Direction::Rows);
+#else
+    invalidateFilter();
+#endif
+}
+
+void XSortFilterProxyModel::_updateFilterAcceptCache()
+{
+    if (m_bIsCustomFilter) {
+        // The rows are hidden by the model itself (XTableView::handleFilter)
+        clearFilterAcceptCache();
+    } else {
+        // Refines the previous result when the new filter only narrows it
+        buildFilterAcceptCache(m_listFilters);
+    }
+}
+
 void XSortFilterProxyModel::setFiltersQuiet(const QList<QString> &listFilters)
 {
     m_listFilters = listFilters;
@@ -112,6 +217,25 @@ void XSortFilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
     m_mapSortMethods.clear();
     clearSortCache();
     clearFilterAcceptCache();
+    clearFilterHistory();
+    _clearProgressiveFilter();
+
+    qint32 nNumberOfConnections = m_listSourceConnections.count();
+
+    for (qint32 i = 0; i < nNumberOfConnections; i++) {
+        disconnect(m_listSourceConnections.at(i));
+    }
+
+    m_listSourceConnections.clear();
+
+    if (sourceModel) {
+        // Any change of the source rows makes the stored filter results stale
+        m_listSourceConnections.append(connect(sourceModel, &QAbstractItemModel::dataChanged, this, &XSortFilterProxyModel::_onSourceDataChanged));
+        m_listSourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &XSortFilterProxyModel::clearFilterHistory));
+        m_listSourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &XSortFilterProxyModel::clearFilterHistory));
+        m_listSourceConnections.append(connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &XSortFilterProxyModel::clearFilterHistory));
+        m_listSourceConnections.append(connect(sourceModel, &QAbstractItemModel::modelReset, this, &XSortFilterProxyModel::clearFilterHistory));
+    }
 
     m_pXModel = dynamic_cast<XModel *>(sourceModel);
 
@@ -152,7 +276,7 @@ void XSortFilterProxyModel::sort(int column, Qt::SortOrder order)
     if (m_bIsCustomSort && m_pXModel) {
         m_pXModel->sortByColumn(column, order);
     } else {
-        if (!(m_bSortCacheValid && (m_nSortCacheColumn == column))) {
+        if (!(m_bSortCacheValid && (m_nSortCacheColumn == column) && m_listSortCacheColumns.isEmpty())) {
             buildSortCache(column);
         }
         QSortFilterProxyModel::sort(column, order);
@@ -160,6 +284,36 @@ void XSortFilterProxyModel::sort(int column, Qt::SortOrder order)
     }
 }
 
+void XSortFilterProxyModel::sortByColumns(const QList<XModel::SORT_COLUMN> &listColumns)
+{
+    if (listColumns.count() <= 1) {
+        if (listColumns.count() == 1) {
+            sort(listColumns.at(0).nColumn, listColumns.at(0).order);
+        }
+
+        return;
+    }
+
+    if (m_bIsCustomSort && m_pXModel) {
+        m_pXModel->sortByColumns(listColumns);
+    } else {
+        if (!(m_bSortCacheValid && isSameSortColumns(m_listSortCacheColumns, listColumns))) {
+            buildSortCache(listColumns);
+        }
+
+        qint32 nColumn = listColumns.at(0).nColumn;
+        Qt::SortOrder order = listColumns.at(0).order;
+
+        if ((sortColumn() == nColumn) && (sortOrder() == order) && dynamicSortFilter()) {
+            invalidate();  // Same primary key: sort() would return early although the other keys changed
+        } else {
+            QSortFilterProxyModel::sort(nColumn, order);
+        }
+
+        clearSortCache();
+    }
+}
+
 void XSortFilterProxyModel::resetModel()
 {
     beginResetModel();
@@ -273,6 +427,7 @@ bool XSortFilterProxyModel::buildSortCache(qint32 nColumn, QAtomicInt *pCancelFl
         return false;
     }
 
+    XModelBulkAccess bulkAccess(m_bIsXmodel ? m_pXModel : nullptr);
     qint32 nRowCount = pSource->rowCount();
     XModel::SORT_METHOD sortMethod = m_mapSortMethods.value(nColumn, XModel::SORT_METHOD_DEFAULT);
 
@@ -281,6 +436,8 @@ bool XSortFilterProxyModel::buildSortCache(qint32 nColumn, QAtomicInt *pCancelFl
     // previous, still valid) cache below.
     QVector<quint64> vecHex;
     QVector<QVariant> vecVariants;
+    QVector<quint32> vecValueIds;
+    QVector<QString> vecValues;
 
     if (sortMethod == XModel::SORT_METHOD_HEX) {
         vecHex.resize(nRowCount);
@@ -302,6 +459,17 @@ bool XSortFilterProxyModel::buildSortCache(qint32 nColumn, QAtomicInt *pCancelFl
                 vecHex[i] = sVal.toULongLong(nullptr, 16);
             }
         }
+    } else if (m_bIsXmodel && m_pXModel && m_pXModel->getColumnValueIds(nColumn, &vecValueIds, &vecValues) && (vecValueIds.count() == nRowCount)) {
+        // Interned column: the distinct values are ordered once and the rows are compared by rank
+        QVector<quint64> vecRanks = getStringRanks(vecValues);
+
+        vecHex.resize(nRowCount);
+
+        for (qint32 i = 0; i < nRowCount; i++) {
+            vecHex[i] = vecRanks.at(vecValueIds.at(i));
+        }
+
+        sortMethod = XModel::SORT_METHOD_HEX;  // lessThan() compares the ranks like hex keys
     } else {
         vecVariants.resize(nRowCount);
 
@@ -330,30 +498,260 @@ bool XSortFilterProxyModel::buildSortCache(qint32 nColumn, QAtomicInt *pCancelFl
 
     m_sortCacheMethod = sortMethod;
     m_nSortCacheColumn = nColumn;
+    m_listSortCacheColumns.clear();
     m_bSortCacheValid = true;
 
     return true;
 }
 
+bool XSortFilterProxyModel::buildSortCache(const QList<XModel::SORT_COLUMN> &listColumns, QAtomicInt *pCancelFlag)
+{
+    if (listColumns.count() == 1) {
+        return buildSortCache(listColumns.at(0).nColumn, pCancelFlag);
+    }
+
+    QAbstractItemModel *pSource = sourceModel();
+
+    if ((!pSource) || listColumns.isEmpty()) {
+        QMutexLocker locker(&m_cacheMutex);
+        m_bSortCacheValid = false;
+        return false;
+    }
+
+    XModelBulkAccess bulkAccess(m_bIsXmodel ? m_pXModel : nullptr);
+    qint32 nRowCount = pSource->rowCount();
+    QList<QVector<quint64>> listKeys;
+
+    for (qint32 i = 0; i < listColumns.count(); i++) {
+        QVector<quint64> vecKeys;
+
+        if (!_getColumnSortKeys(listColumns.at(i).nColumn, &vecKeys, pCancelFlag)) {
+            return false;
+        }
+
+        if (listColumns.at(i).order == Qt::DescendingOrder) {
+            for (qint32 j = 0; j < nRowCount; j++) {
+                vecKeys[j] = ~vecKeys.at(j);
+            }
+        }
+
+        listKeys.append(vecKeys);
+    }
+
+    QVector<qint32> vecOrder = XModel::getMultiSortPermutation(listKeys, pCancelFlag);
+
+    if ((pCancelFlag && pCancelFlag->loadAcquire()) || (vecOrder.count() != nRowCount)) {
+        return false;
+    }
+
+    // QSortFilterProxyModel::sort() runs in the order of the primary column: a descending one gets reversed ranks
+    bool bDescending = (listColumns.at(0).order == Qt::DescendingOrder);
+    QVector<quint64> vecRanks(nRowCount);
+
+    for (qint32 i = 0; i < nRowCount; i++) {
+        vecRanks[vecOrder.at(i)] = bDescending ? (quint64)(nRowCount - 1 - i) : (quint64)i;
+    }
+
+    QMutexLocker locker(&m_cacheMutex);
+
+    m_vecSortCacheHex = vecRanks;
+    m_vecSortCacheVariants.clear();
+    m_sortCacheMethod = XModel::SORT_METHOD_HEX;
+    m_nSortCacheColumn = listColumns.at(0).nColumn;
+    m_listSortCacheColumns = listColumns;
+    m_bSortCacheValid = true;
+
+    return true;
+}
+
+bool XSortFilterProxyModel::_getColumnSortKeys(qint32 nColumn, QVector<quint64> *pVecKeys, QAtomicInt *pCancelFlag)
+{
+    QAbstractItemModel *pSource = sourceModel();
+    qint32 nRowCount = pSource->rowCount();
+    XModel::SORT_METHOD sortMethod = m_mapSortMethods.value(nColumn, XModel::SORT_METHOD_DEFAULT);
+    QVector<quint32> vecValueIds;
+    QVector<QString> vecValues;
+
+    pVecKeys->resize(nRowCount);
+
+    if (sortMethod == XModel::SORT_METHOD_HEX) {
+        bool bSortKeyHex = m_bIsXmodel && m_pXModel && m_pXModel->hasSortKeyHex();
+
+        for (qint32 i = 0; i < nRowCount; i++) {
+            if (pCancelFlag && pCancelFlag->loadAcquire()) {
+                return false;
+            }
+
+            if (bSortKeyHex) {
+                (*pVecKeys)[i] = m_pXModel->getSortKeyHex(i, nColumn);
+            } else {
+                (*pVecKeys)[i] = pSource->data(pSource->index(i, nColumn)).toString().remove(" ").toULongLong(nullptr, 16);
+            }
+        }
+    } else if (m_bIsXmodel && m_pXModel && m_pXModel->getColumnValueIds(nColumn, &vecValueIds, &vecValues) && (vecValueIds.count() == nRowCount)) {
+        QVector<quint64> vecRanks = getStringRanks(vecValues);
+
+        for (qint32 i = 0; i < nRowCount; i++) {
+            (*pVecKeys)[i] = vecRanks.at(vecValueIds.at(i));
+        }
+    } else {
+        // Numbers keep their order as double keys; a column with any non-numeric value is ranked as strings
+        QVector<QVariant> vecVariants(nRowCount);
+        bool bNumeric = true;
+
+        for (qint32 i = 0; i < nRowCount; i++) {
+            if (pCancelFlag && pCancelFlag->loadAcquire()) {
+                return false;
+            }
+
+            vecVariants[i] = pSource->data(pSource->index(i, nColumn));
+            bNumeric = bNumeric && isNumericVariant(vecVariants.at(i));
+        }
+
+        if (bNumeric) {
+            for (qint32 i = 0; i < nRowCount; i++) {
+                (*pVecKeys)[i] = XModel::getDoubleSortKey(vecVariants.at(i).toDouble());
+            }
+        } else {
+            QVector<QString> vecTexts(nRowCount);
+
+            for (qint32 i = 0; i < nRowCount; i++) {
+                vecTexts[i] = vecVariants.at(i).toString();
+            }
+
+            *pVecKeys = getStringRanks(vecTexts);
+        }
+    }
+
+    return !(pCancelFlag && pCancelFlag->loadAcquire());
+}
+
 void XSortFilterProxyModel::clearSortCache()
 {
     QMutexLocker locker(&m_cacheMutex);
     m_vecSortCacheHex.clear();
     m_vecSortCacheVariants.clear();
+    m_listSortCacheColumns.clear();
     m_bSortCacheValid = false;
     m_nSortCacheColumn = -1;
 }
 
-bool XSortFilterProxyModel::buildFilterAcceptCache(const QList<QString> &listFilters, QAtomicInt *pCancelFlag)
+bool XSortFilterProxyModel::buildFilterAcceptCache(const QList<QString> &listFilters, QAtomicInt *pCancelFlag, PROGRESSIVE_FILTER *pProgressive)
+{
+    QVector<bool> vecResult;
+    qint32 nEvaluated = 0;
+
+    if (!computeFilterAccepted(listFilters, &vecResult, &nEvaluated, pCancelFlag, pProgressive)) {
+        if (!sourceModel()) {
+            QMutexLocker locker(&m_cacheMutex);
+            m_bFilterAcceptCacheValid = false;
+            m_nFilterEvaluatedRows = 0;
+        }
+
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_vecFilterAcceptCache = vecResult;
+        m_bFilterAcceptCacheValid = true;
+        m_nFilterEvaluatedRows = nEvaluated;
+    }
+
+    pushFilterHistory(listFilters, vecResult);
+
+    return true;
+}
+
+struct XFilterAcceptBlock {
+    typedef void result_type;
+
+    QAbstractItemModel *pSource;
+    const QList<QString> *pListFilters;
+    const QVector<qint32> *pVecActiveColumns;
+    const QVector<QVector<quint32>> *pVecValueIds;
+    const QVector<QVector<bool>> *pVecValueAccepted;
+    const QVector<bool> *pVecBase;  // nullptr: every row is evaluated
+    bool *pResult;
+    XSortFilterProxyModel::PROGRESSIVE_FILTER *pProgressive;  // Only for a single block in row order
+    QAtomicInt *pCancelFlag;
+    QAtomicInt *pEvaluated;
+    QAtomicInt *pScanned;
+
+    void operator()(const QPair<qint32, qint32> &block) const
+    {
+        qint32 nActiveCount = pVecActiveColumns->count();
+        qint32 nEvaluated = 0;
+        qint32 nScanned = 0;  // Not yet added to pScanned
+
+        for (qint32 i = block.first; i < block.second; i++) {
+            if (pCancelFlag && pCancelFlag->loadAcquire()) {
+                return;
+            }
+
+            bool bAccepted = true;
+
+            if (pVecBase && !pVecBase->at(i)) {
+                bAccepted = false;  // Rejected by a wider filter, so rejected by this one as well
+            } else {
+                nEvaluated++;
+
+                for (qint32 k = 0; k < nActiveCount; k++) {
+                    if (!pVecValueIds->at(k).isEmpty()) {
+                        if (!pVecValueAccepted->at(k).at(pVecValueIds->at(k).at(i))) {
+                            bAccepted = false;
+                            break;
+                        }
+
+                        continue;
+                    }
+
+                    qint32 nColumn = pVecActiveColumns->at(k);
+                    QModelIndex index = pSource->index(i, nColumn);
+
+                    if (index.isValid()) {
+                        QString sValue = pSource->data(index).toString();
+
+                        if (!sValue.contains(pListFilters->at(nColumn), Qt::CaseInsensitive)) {
+                            bAccepted = false;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            pResult[i] = bAccepted;
+            nScanned++;
+
+            if (pProgressive) {
+                pProgressive->vecAccepted.data()[i] = bAccepted;
+            }
+
+            if ((nScanned == 0x400) || (i == block.second - 1)) {
+                if (pProgressive) {
+                    pProgressive->nScanned.storeRelease(i + 1);
+                }
+
+                pScanned->fetchAndAddOrdered(nScanned);
+                nScanned = 0;
+            }
+        }
+
+        pEvaluated->fetchAndAddOrdered(nEvaluated);
+    }
+};
+
+bool XSortFilterProxyModel::computeFilterAccepted(const QList<QString> &listFilters, QVector<bool> *pVecAccepted, qint32 *pnEvaluated,
+                                                  QAtomicInt *pCancelFlag, PROGRESSIVE_FILTER *pProgressive) const
 {
     QAbstractItemModel *pSource = sourceModel();
+    m_nFilterScannedRows.storeRelease(0);
 
     if (!pSource) {
-        QMutexLocker locker(&m_cacheMutex);
-        m_bFilterAcceptCacheValid = false;
         return false;
     }
 
+    XModelBulkAccess bulkAccess(m_bIsXmodel ? m_pXModel : nullptr);
     qint32 nRowCount = pSource->rowCount();
     qint32 nNumberOfFilters = listFilters.count();
 
@@ -366,41 +764,97 @@ bool XSortFilterProxyModel::buildFilterAcceptCache(const QList<QString> &listFil
     }
 
     qint32 nActiveCount = vecActiveColumns.count();
-    QVector<bool> vecResult(nRowCount, true);
+    pVecAccepted->fill(true, nRowCount);
+    *pnEvaluated = 0;
 
-    for (qint32 i = 0; i < nRowCount; i++) {
-        if (pCancelFlag && pCancelFlag->loadAcquire()) {
-            return false;
+    QVector<bool> vecBase;
+    bool bExact = false;
+    bool bIsBase = findFilterHistoryBase(listFilters, &vecBase, &bExact) && (vecBase.count() == nRowCount);
+
+    if (pProgressive && (pProgressive->vecAccepted.count() != nRowCount)) {
+        pProgressive = nullptr;
+    }
+
+    if (bIsBase && bExact) {
+        // Nothing to evaluate: the same filter was computed before
+        *pVecAccepted = vecBase;
+
+        if (pProgressive) {
+            std::copy(vecBase.constBegin(), vecBase.constEnd(), pProgressive->vecAccepted.data());
+            pProgressive->nScanned.storeRelease(nRowCount);
         }
 
-        bool bAccepted = true;
+        m_nFilterScannedRows.storeRelease(nRowCount);
+
+        return !(pCancelFlag && pCancelFlag->loadAcquire());
+    }
 
+    // Interned columns: the needle is tested once per distinct value, the rows look the result up by id
+    QVector<QVector<quint32>> vecValueIds(nActiveCount);
+    QVector<QVector<bool>> vecValueAccepted(nActiveCount);
+
+    if (m_bIsXmodel && m_pXModel && (nRowCount > 0)) {
         for (qint32 k = 0; k < nActiveCount; k++) {
             qint32 nColumn = vecActiveColumns.at(k);
-            QModelIndex index = pSource->index(i, nColumn);
+            QVector<QString> vecValues;
 
-            if (index.isValid()) {
-                QString sValue = pSource->data(index).toString();
+            if (m_pXModel->getColumnValueIds(nColumn, &vecValueIds[k], &vecValues) && (vecValueIds.at(k).count() == nRowCount)) {
+                qint32 nNumberOfValues = vecValues.count();
+                vecValueAccepted[k].resize(nNumberOfValues);
 
-                if (!sValue.contains(listFilters.at(nColumn), Qt::CaseInsensitive)) {
-                    bAccepted = false;
-                    break;
+                for (qint32 j = 0; j < nNumberOfValues; j++) {
+                    vecValueAccepted[k][j] = vecValues.at(j).contains(listFilters.at(nColumn), Qt::CaseInsensitive);
                 }
+            } else {
+                vecValueIds[k].clear();
             }
         }
-
-        vecResult[i] = bAccepted;
     }
 
-    if (pCancelFlag && pCancelFlag->loadAcquire()) {
-        return false;
+    QAtomicInt nEvaluated;
+
+    XFilterAcceptBlock functorBlock;
+    functorBlock.pSource = pSource;
+    functorBlock.pListFilters = &listFilters;
+    functorBlock.pVecActiveColumns = &vecActiveColumns;
+    functorBlock.pVecValueIds = &vecValueIds;
+    functorBlock.pVecValueAccepted = &vecValueAccepted;
+    functorBlock.pVecBase = bIsBase ? &vecBase : nullptr;
+    functorBlock.pResult = pVecAccepted->data();
+    functorBlock.pProgressive = pProgressive;
+    functorBlock.pCancelFlag = pCancelFlag;
+    functorBlock.pEvaluated = &nEvaluated;
+    functorBlock.pScanned = &m_nFilterScannedRows;
+
+    if (pProgressive || !m_bIsXmodel || (nRowCount <= N_FILTER_BLOCK)) {
+        // The progressive result is published as a prefix; other models do not promise a reentrant data()
+        functorBlock(qMakePair(0, nRowCount));
+    } else {
+        // Every block writes its own slice of the result
+        QVector<QPair<qint32, qint32>> vecBlocks;
+
+        for (qint32 i = 0; i < nRowCount; i += N_FILTER_BLOCK) {
+            vecBlocks.append(qMakePair(i, qMin(i + N_FILTER_BLOCK, nRowCount)));
+        }
+
+        QtConcurrent::blockingMap(vecBlocks, functorBlock);
     }
 
+    *pnEvaluated = nEvaluated.loadAcquire();
+
+    return !(pCancelFlag && pCancelFlag->loadAcquire());
+}
+
+qint32 XSortFilterProxyModel::getFilterEvaluatedRows() const
+{
     QMutexLocker locker(&m_cacheMutex);
-    m_vecFilterAcceptCache = vecResult;
-    m_bFilterAcceptCacheValid = true;
 
-    return true;
+    return m_nFilterEvaluatedRows;
+}
+
+qint32 XSortFilterProxyModel::getFilterScannedRows() const
+{
+    return m_nFilterScannedRows.loadAcquire();
 }
 
 void XSortFilterProxyModel::clearFilterAcceptCache()
@@ -409,3 +863,282 @@ void XSortFilterProxyModel::clearFilterAcceptCache()
     m_vecFilterAcceptCache.clear();
     m_bFilterAcceptCacheValid = false;
 }
+
+bool XSortFilterProxyModel::isFilterNarrowing(const QList<QString> &listBaseFilters, const QList<QString> &listFilters)
+{
+    qint32 nCount = qMax(listBaseFilters.count(), listFilters.count());
+
+    for (qint32 i = 0; i < nCount; i++) {
+        QString sBase = listBaseFilters.value(i);
+
+        if (!sBase.isEmpty() && !listFilters.value(i).contains(sBase, Qt::CaseInsensitive)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool XSortFilterProxyModel::findFilterHistoryBase(const QList<QString> &listFilters, QVector<bool> *pVecAccepted, bool *pbExact) const
+{
+    QMutexLocker locker(&m_cacheMutex);
+
+    for (qint32 i = m_listFilterHistory.count() - 1; i >= 0; i--) {
+        const FILTER_STATE &state = m_listFilterHistory.at(i);
+        bool bExact = (state.listFilters == listFilters);
+
+        if (bExact || isFilterNarrowing(state.listFilters, listFilters)) {
+            qint32 nCount = state.baAccepted.size();
+            pVecAccepted->resize(nCount);
+
+            for (qint32 j = 0; j < nCount; j++) {
+                (*pVecAccepted)[j] = state.baAccepted.testBit(j);
+            }
+
+            *pbExact = bExact;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void XSortFilterProxyModel::pushFilterHistory(const QList<QString> &listFilters, const QVector<bool> &vecAccepted)
+{
+    const qint32 N_MAX_HISTORY = 8;
+
+    bool bIsEmpty = true;
+
+    for (qint32 i = 0; i < listFilters.count(); i++) {
+        if (!listFilters.at(i).isEmpty()) {
+            bIsEmpty = false;
+            break;
+        }
+    }
+
+    if (bIsEmpty) {
+        return;  // No filter accepts every row; a full pass is as cheap as a lookup
+    }
+
+    FILTER_STATE state = {};
+    state.listFilters = listFilters;
+
+    qint32 nCount = vecAccepted.count();
+    state.baAccepted.resize(nCount);
+
+    for (qint32 i = 0; i < nCount; i++) {
+        if (vecAccepted.at(i)) {
+            state.baAccepted.setBit(i);
+        }
+    }
+
+    QMutexLocker locker(&m_cacheMutex);
+
+    // Keep the stack ordered from wide to narrow: drop the states this filter does not refine
+    while (!m_listFilterHistory.isEmpty()) {
+        const QList<QString> &listTop = m_listFilterHistory.last().listFilters;
+
+        if ((listTop != listFilters) && isFilterNarrowing(listTop, listFilters)) {
+            break;
+        }
+
+        m_listFilterHistory.removeLast();
+    }
+
+    m_listFilterHistory.append(state);
+
+    while (m_listFilterHistory.count() > N_MAX_HISTORY) {
+        m_listFilterHistory.removeFirst();
+    }
+}
+
+void XSortFilterProxyModel::clearFilterHistory()
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_listFilterHistory.clear();
+}
+
+void XSortFilterProxyModel::_onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &listRoles)
+{
+    // The stored results only depend on the display text of the filtered columns
+    if (!listRoles.isEmpty() && !listRoles.contains(Qt::DisplayRole)) {
+        return;
+    }
+
+    bool bFiltered = false;
+
+    {
+        QMutexLocker locker(&m_cacheMutex);
+
+        for (qint32 i = 0; (i < m_listFilterHistory.count()) && !bFiltered; i++) {
+            const QList<QString> &listFilters = m_listFilterHistory.at(i).listFilters;
+
+            for (qint32 j = topLeft.column(); (j <= bottomRight.column()) && !bFiltered; j++) {
+                bFiltered = !listFilters.value(j).isEmpty();
+            }
+        }
+    }
+
+    if (bFiltered) {
+        clearFilterHistory();
+    }
+}
+
+QSharedPointer<XSortFilterProxyModel::PROGRESSIVE_FILTER> XSortFilterProxyModel::beginProgressiveFilter(const QList<QString> &listFilters)
+{
+    if (!m_pProgressive) {
+        // Kept for abortProgressiveFilter(); a pass that replaces a running one keeps the state from before both
+        m_listProgressivePrevFilters = m_listFilters;
+
+        {
+            QMutexLocker locker(&m_cacheMutex);
+            m_vecProgressivePrevAccepted = m_vecFilterAcceptCache;
+            m_bProgressivePrevValid = m_bFilterAcceptCacheValid;
+        }
+
+        if (!m_bProgressivePrevValid) {
+            bool bExact = false;
+            QVector<bool> vecAccepted;
+
+            // Shown from the lazy filterAcceptsRow(): the result may still be on the history stack
+            if (findFilterHistoryBase(m_listFilters, &vecAccepted, &bExact) && bExact) {
+                m_vecProgressivePrevAccepted = vecAccepted;
+                m_bProgressivePrevValid = true;
+            }
+        }
+    }
+
+    qint32 nRowCount = sourceModel() ? sourceModel()->rowCount() : 0;
+
+    m_pProgressive = QSharedPointer<PROGRESSIVE_FILTER>::create();
+    m_pProgressive->vecAccepted.fill(false, nRowCount);
+    m_nProgressivePublished = 0;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    beginFilterChange();
+#endif
+    m_listFilters = listFilters;
+
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_vecFilterAcceptCache.fill(false, nRowCount);
+        m_bFilterAcceptCacheValid = true;
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    endFilterChange(QSortFilterProxyModel::Direction::Rows);
+#else
+    invalidateFilter();
+#endif
+
+    return m_pProgressive;
+}
+
+void XSortFilterProxyModel::publishProgressiveFilter()
+{
+    if (!m_pProgressive) {
+        return;
+    }
+
+    qint32 nRowCount = m_pProgressive->vecAccepted.count();
+    qint32 nScanned = m_pProgressive->nScanned.loadAcquire();
+
+    if (nScanned <= m_nProgressivePublished) {
+        return;
+    }
+
+    // QSortFilterProxyModel re-evaluates every source row on a filter change, so a publish costs O(rows).
+    // After the first one publish only when the scanned part has doubled: a pass makes O(log rows) of them.
+    if ((m_nProgressivePublished > 0) && (nScanned < nRowCount) && (nScanned < 2 * m_nProgressivePublished)) {
+        return;
+    }
+
+    const bool *pScanned = m_pProgressive->vecAccepted.constData();
+    bool bNewRows = (std::find(pScanned + m_nProgressivePublished, pScanned + nScanned, true) != pScanned + nScanned);
+
+    if (!bNewRows) {
+        // The published rows are false already
+        m_nProgressivePublished = nScanned;
+        return;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    beginFilterChange();
+#endif
+    {
+        QMutexLocker locker(&m_cacheMutex);
+
+        if (m_vecFilterAcceptCache.count() >= nScanned) {
+            std::copy(pScanned + m_nProgressivePublished, pScanned + nScanned, m_vecFilterAcceptCache.begin() + m_nProgressivePublished);
+        }
+    }
+
+    m_nProgressivePublished = nScanned;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    endFilterChange(QSortFilterProxyModel::Direction::Rows);
+#else
+    invalidateFilter();
+#endif
+}
+
+void XSortFilterProxyModel::endProgressiveFilter()
+{
+    if (!m_pProgressive) {
+        return;
+    }
+
+    // buildFilterAcceptCache() has stored the complete result: publish the remaining rows
+    _clearProgressiveFilter();
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    beginFilterChange();
+    endFilterChange(QSortFilterProxyModel::Direction::Rows);
+#else
+    invalidateFilter();
+#endif
+}
+
+void XSortFilterProxyModel::abortProgressiveFilter()
+{
+    if (!m_pProgressive) {
+        return;
+    }
+
+    m_pProgressive.clear();
+
+    // Put back the result saved by beginProgressiveFilter(), nothing is evaluated again
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    beginFilterChange();
+#endif
+    m_listFilters = m_listProgressivePrevFilters;
+
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_vecFilterAcceptCache = m_vecProgressivePrevAccepted;
+        m_bFilterAcceptCacheValid = m_bProgressivePrevValid && (m_vecFilterAcceptCache.count() == (sourceModel() ? sourceModel()->rowCount() : 0));
+
+        if (!m_bFilterAcceptCacheValid) {
+            m_vecFilterAcceptCache.clear();
+        }
+    }
+
+    _clearProgressiveFilter();
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    endFilterChange(QSortFilterProxyModel::Direction::Rows);
+#else
+    invalidateFilter();
+#endif
+}
+
+void XSortFilterProxyModel::_clearProgressiveFilter()
+{
+    m_pProgressive.clear();
+    m_listProgressivePrevFilters.clear();
+    m_vecProgressivePrevAccepted.clear();
+    m_bProgressivePrevValid = false;
+}
+
+bool XSortFilterProxyModel::isProgressiveFilter() const
+{
+    return !m_pProgressive.isNull();
+}
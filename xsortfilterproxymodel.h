@@ -23,13 +23,20 @@
 #define XSORTFILTERPROXYMODEL_H
 
 #include <QSortFilterProxyModel>
+#include <QBitArray>
 #include <QVector>
 #include <QAtomicInt>
 #include <QMutex>
+#include <QSharedPointer>
 #include "xmodel.h"
 
 class XSortFilterProxyModel : public QSortFilterProxyModel {
 public:
+    struct PROGRESSIVE_FILTER {
+        QVector<bool> vecAccepted;  // Preallocated by beginProgressiveFilter(); rows [0, nScanned) are final
+        QAtomicInt nScanned;
+    };
+
     explicit XSortFilterProxyModel(QObject *pParent = nullptr);
     void setFilters(const QList<QString> &listFilters);
     void setColumnFilter(qint32 nColumn, const QString &sFilter);
@@ -38,20 +45,53 @@ public:
     void setSourceModel(QAbstractItemModel *sourceModel) override;
     QVariant data(const QModelIndex &index, int nRole = Qt::DisplayRole) const override;
     virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+    // Stable sort by several columns, the first one is the primary key (and the proxy's sortColumn())
+    void sortByColumns(const QList<XModel::SORT_COLUMN> &listColumns);
     void resetModel();
 
     // Pure read-only computation over sourceModel(); safe to call from a worker thread.
     // pCancelFlag is polled between rows and, if set, aborts early returning false
     // (the corresponding cache is left/marked invalid).
     bool buildSortCache(qint32 nColumn, QAtomicInt *pCancelFlag = nullptr);
-    bool buildFilterAcceptCache(const QList<QString> &listFilters, QAtomicInt *pCancelFlag = nullptr);
+    // Multi-column: every column becomes a typed 64-bit key (hex, interned rank, number or string rank),
+    // the composite key is radix sorted and the cache holds the rank of each source row
+    bool buildSortCache(const QList<XModel::SORT_COLUMN> &listColumns, QAtomicInt *pCancelFlag = nullptr);
+    bool buildFilterAcceptCache(const QList<QString> &listFilters, QAtomicInt *pCancelFlag = nullptr, PROGRESSIVE_FILTER *pProgressive = nullptr);
+    // The pass of buildFilterAcceptCache() without touching the cache or the history. XModel sources are evaluated
+    // in parallel row blocks on the thread pool (their data() is reentrant); a progressive pass scans in row order.
+    bool computeFilterAccepted(const QList<QString> &listFilters, QVector<bool> *pVecAccepted, qint32 *pnEvaluated, QAtomicInt *pCancelFlag = nullptr,
+                               PROGRESSIVE_FILTER *pProgressive = nullptr) const;
     void clearFilterAcceptCache();
+    // Rows the last completed buildFilterAcceptCache() tested; a narrowing pass skips the rows a wider filter rejected
+    qint32 getFilterEvaluatedRows() const;
+    qint32 getFilterScannedRows() const;  // Thread-safe: progress of a running filter pass
 
     // Assigns m_listFilters without triggering invalidateFilter(). For callers (the
     // threaded pipeline) that apply the new filter state themselves once a matching
     // buildFilterAcceptCache() result is ready, instead of paying for a synchronous
     // filter pass twice.
     void setFiltersQuiet(const QList<QString> &listFilters);
+    // setFilters() leaves the evaluation to filterAcceptsRow(); this one evaluates the filter now,
+    // refining an earlier wider result from the history. For the synchronous filter path of the view.
+    void setFiltersRefined(const QList<QString> &listFilters);
+
+    // Incremental filtering: a filter that only extends the previous needles can only
+    // shrink the result, so it is evaluated over the rows that still pass; going back
+    // (backspace) restores an earlier result from the stack. Shared with the custom-filter
+    // path of XTableView, which stores its hidden-row state here as accepted rows.
+    static bool isFilterNarrowing(const QList<QString> &listBaseFilters, const QList<QString> &listFilters);
+    bool findFilterHistoryBase(const QList<QString> &listFilters, QVector<bool> *pVecAccepted, bool *pbExact) const;
+    void pushFilterHistory(const QList<QString> &listFilters, const QVector<bool> &vecAccepted);
+    void clearFilterHistory();
+
+    // Progressive filtering: the view starts empty and the rows accepted by the running
+    // buildFilterAcceptCache() are published from the GUI thread each time the scanned part doubles.
+    // abortProgressiveFilter() restores the filter and the result that were shown before.
+    QSharedPointer<PROGRESSIVE_FILTER> beginProgressiveFilter(const QList<QString> &listFilters);
+    void publishProgressiveFilter();
+    void endProgressiveFilter();
+    void abortProgressiveFilter();
+    bool isProgressiveFilter() const;
 
 protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
@@ -59,6 +99,10 @@ protected:
 
 private:
     void clearSortCache();
+    bool _getColumnSortKeys(qint32 nColumn, QVector<quint64> *pVecKeys, QAtomicInt *pCancelFlag);
+    void _updateFilterAcceptCache();
+    void _clearProgressiveFilter();
+    void _onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &listRoles);
 
     bool m_bIsXmodel;
     bool m_bIsCustomFilter;
@@ -71,9 +115,26 @@ private:
     XModel::SORT_METHOD m_sortCacheMethod;
     QVector<quint64> m_vecSortCacheHex;
     QVector<QVariant> m_vecSortCacheVariants;
+    QList<XModel::SORT_COLUMN> m_listSortCacheColumns;  // Not empty: m_vecSortCacheHex holds multi-column ranks
 
     bool m_bFilterAcceptCacheValid;
     QVector<bool> m_vecFilterAcceptCache;
+    qint32 m_nFilterEvaluatedRows;
+    mutable QAtomicInt m_nFilterScannedRows;
+
+    struct FILTER_STATE {
+        QList<QString> listFilters;
+        QBitArray baAccepted;
+    };
+
+    QList<FILTER_STATE> m_listFilterHistory;  // Bottom: widest filter, top: the latest narrowing
+    QList<QMetaObject::Connection> m_listSourceConnections;
+
+    QSharedPointer<PROGRESSIVE_FILTER> m_pProgressive;
+    QList<QString> m_listProgressivePrevFilters;
+    QVector<bool> m_vecProgressivePrevAccepted;
+    bool m_bProgressivePrevValid;
+    qint32 m_nProgressivePublished;
 
     // Guards the sort/filter cache members above: buildSortCache()/buildFilterAcceptCache()
     // may run on a worker thread while lessThan()/filterAcceptsRow() run on the GUI thread
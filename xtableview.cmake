@@ -5,6 +5,8 @@ if (NOT DEFINED XMODEL_SOURCES)
     set(XTABLEVIEW_SOURCES ${XTABLEVIEW_SOURCES} ${XMODEL_SOURCES})
 endif()
 
+set(XTABLEVIEW_LIBS ${XTABLEVIEW_LIBS} ${XMODEL_LIBS})
+
 set(XTABLEVIEW_SOURCES
     ${XTABLEVIEW_SOURCES}
     ${CMAKE_CURRENT_LIST_DIR}/xtableview.cpp
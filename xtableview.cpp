@@ -19,10 +19,49 @@
  * SOFTWARE.
  */
 #include "xtableview.h"
+#include <QCoreApplication>
 #include <QPointer>
 #include <QSignalBlocker>
+#include <QThread>
 #include <QtConcurrent>
 
+// Filter scheduling: the cost of a pass is predicted from the throughput of the previous passes
+static const double D_FILTER_DEFAULT_ROWS_PER_MS = 1000.0;  // Until the first pass of a model is measured
+static const qint64 N_FILTER_SYNC_LIMIT_MS = 16;            // Cheaper passes run at once on the GUI thread
+static const qint64 N_FILTER_SAMPLE_MIN_NS = 1000000;       // Shorter passes (history hits) are not measured
+static const qint32 N_FILTER_DEBOUNCE_MIN_MS = 50;
+static const qint32 N_FILTER_DEBOUNCE_THREADED_MAX_MS = 200;  // Canceled by the next keystroke anyway
+static const qint32 N_FILTER_DEBOUNCE_MAX_MS = 400;           // Blocks the GUI thread: wait for a pause in typing
+
+// Replaced models are deleted on this thread: freeing millions of records must not block the GUI.
+// Stopped on aboutToQuit(); the models still queued are deleted when its event loop ends.
+static QThread *g_pXTVReaperThread = nullptr;
+static bool g_bXTVReaperStopped = false;
+
+static void _xtvStopReaperThread()
+{
+    if (g_pXTVReaperThread) {
+        g_pXTVReaperThread->quit();
+        g_pXTVReaperThread->wait();
+        delete g_pXTVReaperThread;
+        g_pXTVReaperThread = nullptr;
+    }
+
+    g_bXTVReaperStopped = true;
+}
+
+static QThread *_xtvGetReaperThread()
+{
+    if (!g_pXTVReaperThread && !g_bXTVReaperStopped && QCoreApplication::instance()) {
+        g_pXTVReaperThread = new QThread;
+        g_pXTVReaperThread->setObjectName(QStringLiteral("XTableView model reaper"));
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, _xtvStopReaperThread);
+        g_pXTVReaperThread->start(QThread::LowestPriority);
+    }
+
+    return g_pXTVReaperThread;
+}
+
 XTableView::XTableView(QWidget *pParent) : QTableView(pParent)
 {
     m_pOldModel = nullptr;
@@ -41,14 +80,17 @@ XTableView::XTableView(QWidget *pParent) : QTableView(pParent)
     m_bApplyingAsyncSort = false;
     m_pAsyncWatcher = nullptr;
     m_pendingOperation = OPERATION_NONE;
-    m_nPendingSortColumn = -1;
-    m_pendingSortOrder = Qt::AscendingOrder;
     m_nCustomFilterGeneration = 0;
+    m_bProgressiveEnabled = false;
+    m_nProgressiveGeneration = 0;
+    m_dFilterRowsPerMs = 0;
+    m_nFilterPassRows = 0;
 
     setHorizontalHeader(m_pHeaderView);
 
     connect(m_pHeaderView, SIGNAL(filterChanged()), this, SLOT(onFilterChanged()));
     connect(m_pHeaderView, SIGNAL(sortRequested(int, Qt::SortOrder)), this, SLOT(onSortChanged(int, Qt::SortOrder)));
+    connect(m_pHeaderView, SIGNAL(multiSortRequested(QList<XModel::SORT_COLUMN>)), this, SLOT(onMultiSortChanged(QList<XModel::SORT_COLUMN>)));
     connect(horizontalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(horizontalScroll()));
     connect(this, SIGNAL(invalidateSignal()), m_pSortFilterProxyModel, SLOT(invalidate()));
 
@@ -56,6 +98,14 @@ XTableView::XTableView(QWidget *pParent) : QTableView(pParent)
     m_pFilterTimer->setSingleShot(true);
     connect(m_pFilterTimer, SIGNAL(timeout()), this, SLOT(onFilterApply()));
 
+    m_pProgressiveTimer = new QTimer(this);
+    m_pProgressiveTimer->setInterval(50);
+    connect(m_pProgressiveTimer, SIGNAL(timeout()), this, SLOT(onProgressiveTimer()));
+
+    m_pFilterProgressTimer = new QTimer(this);
+    m_pFilterProgressTimer->setInterval(100);
+    connect(m_pFilterProgressTimer, SIGNAL(timeout()), this, SLOT(onFilterProgressTimer()));
+
     setSortingEnabled(true);
     setWordWrap(false);
     verticalHeader()->setDefaultSectionSize(verticalHeader()->minimumSectionSize());
@@ -81,6 +131,8 @@ void XTableView::setCustomModel(QAbstractItemModel *pModel, bool bFilterEnabled)
     // TODO Stretch last section
     m_nCustomFilterGeneration++;
     cancelAsyncOperation();
+    m_dFilterRowsPerMs = 0;
+    m_filterPassTimer.invalidate();
 
     m_pOldModel = m_pModel;
 
@@ -129,6 +181,20 @@ void XTableView::setCustomModel(QAbstractItemModel *pModel, bool bFilterEnabled)
     }
 
     adjust();
+
+    if (m_pXModel) {
+        m_pXModel->setViewed();
+    }
+}
+
+void XTableView::showEvent(QShowEvent *pEvent)
+{
+    QTableView::showEvent(pEvent);
+
+    // A tab brought to front: its model must be the last one to give up its caches
+    if (m_pXModel) {
+        m_pXModel->setViewed();
+    }
 }
 
 void XTableView::onSourceModelReset()
@@ -145,6 +211,8 @@ void XTableView::clear()
 {
     m_nCustomFilterGeneration++;
     cancelAsyncOperation();
+    m_dFilterRowsPerMs = 0;
+    m_filterPassTimer.invalidate();
     m_pSortFilterProxyModel->setSourceModel(nullptr);
     replaceModel(nullptr);
     deleteOldModel(&m_pModel);
@@ -166,9 +234,32 @@ void XTableView::replaceModel(QAbstractItemModel *pModel)
 void XTableView::deleteOldModel(QAbstractItemModel **ppOldModel)
 {
     if (ppOldModel && *ppOldModel) {
-        delete (*ppOldModel);
-
+        QAbstractItemModel *pOldModel = *ppOldModel;
         (*ppOldModel) = nullptr;
+
+        if (m_pXModel == pOldModel) {
+            m_pXModel = nullptr;
+            m_bIsXmodel = false;
+        }
+
+        QThread *pReaperThread = _xtvGetReaperThread();
+
+        if (pReaperThread && (pOldModel->thread() == QThread::currentThread())) {
+            // Detached from the proxy and the view already; nothing on the GUI thread may reach it anymore
+            disconnect(pOldModel, nullptr, this, nullptr);
+
+            XModel *pXModel = qobject_cast<XModel *>(pOldModel);
+
+            if (pXModel) {
+                pXModel->prepareForDeferredDelete();
+            }
+
+            pOldModel->setParent(nullptr);
+            pOldModel->moveToThread(pReaperThread);
+            pOldModel->deleteLater();
+        } else {
+            delete pOldModel;
+        }
     }
 }
 
@@ -195,23 +286,39 @@ void XTableView::handleFilter()
 
     qint32 nActiveCount = vecActiveColumns.count();
 
+    // A narrowing filter only has to look at the rows the previous one accepted
+    QVector<bool> vecBase;
+    bool bExact = false;
+    bool bIsBase = m_pSortFilterProxyModel->findFilterHistoryBase(listFilters, &vecBase, &bExact) && (vecBase.count() == nNumberOfRows);
+
+    QVector<bool> vecAccepted(nNumberOfRows, true);
+    qint32 nEvaluated = 0;
+
     for (qint32 i = 0; (i < nNumberOfRows) && (!m_bIsStop); i++) {
         bool bHidden = false;
 
-        for (qint32 k = 0; k < nActiveCount; k++) {
-            qint32 nColumn = vecActiveColumns.at(k);
-            QModelIndex index = m_pModel->index(i, nColumn);
+        if (bIsBase && (bExact || !vecBase.at(i))) {
+            bHidden = !vecBase.at(i);
+        } else {
+            nEvaluated++;
+
+            for (qint32 k = 0; k < nActiveCount; k++) {
+                qint32 nColumn = vecActiveColumns.at(k);
+                QModelIndex index = m_pModel->index(i, nColumn);
 
-            if (index.isValid()) {
-                QString sValue = m_pModel->data(index).toString();
+                if (index.isValid()) {
+                    QString sValue = m_pModel->data(index).toString();
 
-                if (!sValue.contains(listFilters.at(nColumn), Qt::CaseInsensitive)) {
-                    bHidden = true;
-                    break;
+                    if (!sValue.contains(listFilters.at(nColumn), Qt::CaseInsensitive)) {
+                        bHidden = true;
+                        break;
+                    }
                 }
             }
         }
 
+        vecAccepted[i] = !bHidden;
+
         // Only set hidden=true; non-hidden rows already cleared by clearRowHidden()
         if (m_bIsXmodel && bHidden) {
             m_pXModel->setRowHidden(i, true);
@@ -222,6 +329,8 @@ void XTableView::handleFilter()
 #ifdef QT_DEBUG
         qDebug("XTableView::handleFilter(): Stop at invalid signal");
 #endif
+        m_nFilterPassRows = nEvaluated;
+        m_pSortFilterProxyModel->pushFilterHistory(listFilters, vecAccepted);
         m_pSortFilterProxyModel->blockSignals(true);
         m_pSortFilterProxyModel->invalidate();
         m_pSortFilterProxyModel->blockSignals(false);
@@ -245,6 +354,8 @@ void XTableView::setFilterEnabled(qint32 nColumn, bool bFilterEnabled)
 
 void XTableView::setColumnFilterString(qint32 nColumn, const QString &sFilter)
 {
+    m_filterPassTimer.invalidate();  // Not a scheduled pass: not measured
+
     if (m_bThreadedEnabled && m_bIsCustomFilter) {
         QList<QString> listFilters = m_listCurrentFilters;
 
@@ -273,9 +384,17 @@ void XTableView::setColumnFilterString(qint32 nColumn, const QString &sFilter)
         return;
     }
 
+    // A worker reading the model must not overlap the synchronous pass; a pending sort is started again after it
+    PENDING_OPERATION opPending = m_pendingOperation;
+    cancelAsyncOperation();
+
     m_pSortFilterProxyModel->setColumnFilter(nColumn, sFilter);
     m_listCurrentFilters = m_pSortFilterProxyModel->getFilters();
 
+    if (opPending == OPERATION_SORT) {
+        startAsyncSortOperation(m_listPendingSortColumns);
+    }
+
     if (m_bIsCustomFilter) {
         m_bIsStop = true;
         m_watcher.waitForFinished();
@@ -297,6 +416,16 @@ bool XTableView::isThreadedFilterSortEnabled() const
     return m_bThreadedEnabled;
 }
 
+void XTableView::setProgressiveFilterEnabled(bool bEnabled)
+{
+    m_bProgressiveEnabled = bEnabled;
+}
+
+bool XTableView::isProgressiveFilterEnabled() const
+{
+    return m_bProgressiveEnabled;
+}
+
 void XTableView::setSortingEnabled(bool bEnable)
 {
     m_bSortingEnabled = bEnable;
@@ -320,16 +449,25 @@ bool XTableView::isSortingEnabled() const
 
 void XTableView::sortByColumn(int column, Qt::SortOrder order)
 {
-    if (!m_bSortingEnabled && (column >= 0)) {
+    XModel::SORT_COLUMN sortColumn = {column, order};
+
+    QList<XModel::SORT_COLUMN> listColumns;
+    listColumns.append(sortColumn);
+
+    sortByColumns(listColumns);
+}
+
+void XTableView::sortByColumns(const QList<XModel::SORT_COLUMN> &listColumns)
+{
+    if (listColumns.isEmpty() || (!m_bSortingEnabled && (listColumns.at(0).nColumn >= 0))) {
         return;
     }
 
     if (m_pHeaderView) {
-        QSignalBlocker blocker(m_pHeaderView);
-        m_pHeaderView->setSortIndicator(column, order);
+        m_pHeaderView->setSortColumns((listColumns.at(0).nColumn >= 0) ? listColumns : QList<XModel::SORT_COLUMN>());
     }
 
-    onSortChanged(column, order);
+    onMultiSortChanged(listColumns);
 }
 
 void XTableView::adjust()
@@ -359,7 +497,60 @@ void XTableView::adjust()
 
 void XTableView::onFilterChanged()
 {
-    m_pFilterTimer->start(300);
+    // A new keystroke makes the running pass useless: stop it instead of letting it finish
+    if (m_pendingOperation == OPERATION_FILTER) {
+        m_nCustomFilterGeneration++;
+        _detachProgressiveFilter();
+        cancelAsyncOperation(false);
+    }
+
+    m_filterPassTimer.invalidate();
+
+    qint64 nPredicted = _getPredictedFilterCost();
+    qint32 nDebounce = 0;
+
+    if (nPredicted > N_FILTER_SYNC_LIMIT_MS) {
+        if (m_bThreadedEnabled) {
+            nDebounce = qBound((qint64)N_FILTER_DEBOUNCE_MIN_MS, nPredicted / 4, (qint64)N_FILTER_DEBOUNCE_THREADED_MAX_MS);
+        } else {
+            nDebounce = qBound((qint64)N_FILTER_DEBOUNCE_MIN_MS, nPredicted, (qint64)N_FILTER_DEBOUNCE_MAX_MS);
+        }
+    }
+
+    m_pFilterTimer->start(nDebounce);
+}
+
+qint64 XTableView::_getPredictedFilterCost() const
+{
+    qint64 nResult = 0;
+
+    if (m_pModel) {
+        double dRowsPerMs = (m_dFilterRowsPerMs > 0) ? m_dFilterRowsPerMs : D_FILTER_DEFAULT_ROWS_PER_MS;
+        nResult = (qint64)(m_pModel->rowCount() / dRowsPerMs);
+    }
+
+    return nResult;
+}
+
+void XTableView::_beginFilterPass()
+{
+    m_nFilterPassRows = 0;  // Set by the pass: narrowing filters evaluate only a part of the rows
+    m_filterPassTimer.start();
+}
+
+void XTableView::_endFilterPass()
+{
+    if (m_filterPassTimer.isValid()) {
+        qint64 nElapsed = m_filterPassTimer.nsecsElapsed();
+        m_filterPassTimer.invalidate();
+
+        if ((nElapsed >= N_FILTER_SAMPLE_MIN_NS) && (m_nFilterPassRows > 0)) {
+            double dRowsPerMs = m_nFilterPassRows / (nElapsed / 1000000.0);
+
+            // Smoothed: one slow pass (cold caches, a busy machine) does not swing the debounce
+            m_dFilterRowsPerMs = (m_dFilterRowsPerMs > 0) ? ((m_dFilterRowsPerMs + dRowsPerMs) / 2) : dRowsPerMs;
+        }
+    }
 }
 
 void XTableView::onFilterApply()
@@ -375,8 +566,13 @@ void XTableView::onFilterApply()
 
     m_listCurrentFilters = listFilters;
 
+    // Threaded only when enabled and the pass is long enough to outweigh handing it to a worker
+    bool bThreaded = m_bThreadedEnabled && (_getPredictedFilterCost() > N_FILTER_SYNC_LIMIT_MS);
+
+    _beginFilterPass();
+
     if (m_bIsCustomFilter) {
-        if (m_bThreadedEnabled) {
+        if (bThreaded) {
             startAsyncCustomFilterOperation(listFilters);
             return;
         }
@@ -390,16 +586,19 @@ void XTableView::onFilterApply()
         handleFilter();
         emit busyChanged(false);
     } else {
-        if (m_bThreadedEnabled) {
+        if (bThreaded) {
             startAsyncFilterOperation(listFilters);
             return;
         }
 
-        m_pSortFilterProxyModel->setFilters(listFilters);
+        m_pSortFilterProxyModel->setFiltersRefined(listFilters);
+        m_nFilterPassRows = m_pSortFilterProxyModel->getFilterEvaluatedRows();
         emit invalidateSignal();
         // m_pSortFilterProxyModel->invalidate();
     }
 
+    _endFilterPass();
+
 #ifdef QT_DEBUG
     qDebug("XTableView::onFilterChanged(): Elapsed time: %lld ms", timer.elapsed());
     // 16266 ms
@@ -410,26 +609,45 @@ void XTableView::onFilterApply()
 
 void XTableView::onSortChanged(int column, Qt::SortOrder order)
 {
-    if ((!m_bSortingEnabled && (column >= 0)) || m_bApplyingAsyncSort) {
+    XModel::SORT_COLUMN sortColumn = {column, order};
+
+    QList<XModel::SORT_COLUMN> listColumns;
+    listColumns.append(sortColumn);
+
+    onMultiSortChanged(listColumns);
+}
+
+void XTableView::onMultiSortChanged(const QList<XModel::SORT_COLUMN> &listColumns)
+{
+    if (listColumns.isEmpty() || (!m_bSortingEnabled && (listColumns.at(0).nColumn >= 0)) || m_bApplyingAsyncSort) {
         return;
     }
 
-    if (m_bThreadedEnabled && !m_bIsCustomSort) {
-        startAsyncSortOperation(column, order);
+    // A model that sorts itself computes the order on the worker as well; its partial sort shows the top rows at once instead
+    if (m_bThreadedEnabled && (!m_bIsCustomSort || (!m_bIsCustomFilter && !m_pXModel->isPartialSortEnabled()))) {
+        startAsyncSortOperation(listColumns);
         return;
     }
 
+    // The model sorts itself: no worker may read it while the row order changes. A pending filter pass is started again.
+    PENDING_OPERATION opPending = m_pendingOperation;
+    cancelAsyncOperation();
+
     if (m_bIsCustomFilter) {
         m_bIsStop = true;
         m_watcher.waitForFinished();
         m_bIsStop = false;
     }
 
-    m_pSortFilterProxyModel->sort(column, order);
+    m_pSortFilterProxyModel->sortByColumns(listColumns);
 
     if (m_bIsCustomFilter) {
         handleFilter();
     }
+
+    if (opPending == OPERATION_FILTER) {
+        startAsyncFilterOperation(m_listPendingFilters);
+    }
 }
 
 void XTableView::horizontalScroll()
@@ -437,135 +655,101 @@ void XTableView::horizontalScroll()
     m_pHeaderView->adjustPositions();
 }
 
-static QVector<bool> _xtvComputeHiddenRows(const QVector<QStringList> &listRows, const QStringList &listActiveFilters)
+bool XTableView::_computeCustomFilter(XSortFilterProxyModel *pProxy, const QList<QString> &listFilters, const QSharedPointer<QAtomicInt> &pCancelFlag,
+                                      const QSharedPointer<CUSTOM_FILTER_RESULT> &pResult)
 {
-    const qint32 nNumberOfRows = listRows.count();
-    const qint32 nNumberOfFilters = listActiveFilters.count();
-    QVector<bool> vecHidden(nNumberOfRows, false);
+    return pProxy->computeFilterAccepted(listFilters, &pResult->vecAccepted, &pResult->nEvaluated, pCancelFlag.data());
+}
 
-    for (qint32 i = 0; i < nNumberOfRows; i++) {
-        bool bHidden = false;
+void XTableView::applyCustomFilterResult(const QList<QString> &listFilters, const QVector<bool> &vecAccepted)
+{
+    if (m_pXModel) {
+        m_pSortFilterProxyModel->setFiltersQuiet(listFilters);
+        m_pSortFilterProxyModel->pushFilterHistory(listFilters, vecAccepted);
+        m_pXModel->clearRowHidden();
 
-        for (qint32 j = 0; j < nNumberOfFilters; j++) {
-            if (!listRows.at(i).at(j).contains(listActiveFilters.at(j), Qt::CaseInsensitive)) {
-                bHidden = true;
-                break;
+        for (qint32 i = 0; i < vecAccepted.count(); i++) {
+            if (!vecAccepted.at(i)) {
+                m_pXModel->setRowHidden(i, true);
             }
         }
 
-        vecHidden[i] = bHidden;
+        m_pSortFilterProxyModel->invalidate();
+        reset();
     }
 
-    return vecHidden;
+    _endFilterPass();
 }
 
-// File-scope functor used as the finished-slot for the custom-filter watcher;
-// declared as a friend of XTableView so it can apply the result exactly the
-// way the inline code did (reading the members at callback time).
-struct XTableViewCustomFilterFinished {
-    XTableView *pView;
-    QFutureWatcher<QVector<bool>> *pWatcher;
-    qint32 nGeneration;
-    QList<QString> listFilters;
-
-    void operator()() const;
-};
-
-void XTableViewCustomFilterFinished::operator()() const
+void XTableView::onFilterProgressTimer()
 {
-    QVector<bool> vecHidden = pWatcher->result();
-    pWatcher->deleteLater();
+    emit filterProgress(m_pSortFilterProxyModel->getFilterScannedRows(), m_pModel ? m_pModel->rowCount() : 0);
+}
 
-    if (pView->m_nCustomFilterGeneration != nGeneration) {
+void XTableView::onProgressiveTimer()
+{
+    if (!m_pAsyncProgressive || (m_nProgressiveGeneration != m_nCustomFilterGeneration)) {
+        // Superseded (new filter, new model): nothing of this pass may be shown anymore
+        m_pProgressiveTimer->stop();
         return;
     }
 
-    if (pView->m_pXModel) {
-        pView->m_pSortFilterProxyModel->setFiltersQuiet(listFilters);
-        pView->m_pXModel->clearRowHidden();
-
-        for (qint32 i = 0; i < vecHidden.count(); i++) {
-            if (vecHidden.at(i)) {
-                pView->m_pXModel->setRowHidden(i, true);
-            }
-        }
-
-        pView->m_pSortFilterProxyModel->invalidate();
-        pView->reset();
-    }
-
-    emit pView->busyChanged(false);
+    m_pSortFilterProxyModel->publishProgressiveFilter();
 }
 
 void XTableView::startAsyncCustomFilterOperation(const QList<QString> &listFilters)
 {
+    cancelAsyncOperation(false);
+
     m_nCustomFilterGeneration++;
-    const qint32 nGeneration = m_nCustomFilterGeneration;
 
     if (!m_pModel || !m_pXModel) {
-        emit busyChanged(false);
         return;
     }
 
-    emit busyChanged(true);
+    bool bActive = false;
 
-    QVector<qint32> vecActiveColumns;
-    QStringList listActiveFilters;
-
-    for (qint32 i = 0; i < listFilters.count(); i++) {
-        if (!listFilters.at(i).isEmpty() && (i < m_pModel->columnCount())) {
-            vecActiveColumns.append(i);
-            listActiveFilters.append(listFilters.at(i));
-        }
+    for (qint32 i = 0; (i < listFilters.count()) && (i < m_pModel->columnCount()); i++) {
+        bActive = bActive || !listFilters.at(i).isEmpty();
     }
 
-    if (vecActiveColumns.isEmpty()) {
+    if (!bActive) {
         m_pSortFilterProxyModel->setFiltersQuiet(listFilters);
         m_pXModel->clearRowHidden();
         m_pSortFilterProxyModel->invalidate();
         reset();
-        emit busyChanged(false);
         return;
     }
 
-    const qint32 nNumberOfRows = m_pModel->rowCount();
-    QVector<QStringList> listRows;
-    listRows.reserve(nNumberOfRows);
-
-    for (qint32 i = 0; i < nNumberOfRows; i++) {
-        QStringList listRow;
-        listRow.reserve(vecActiveColumns.count());
-
-        for (qint32 j = 0; j < vecActiveColumns.count(); j++) {
-            const QModelIndex index = m_pModel->index(i, vecActiveColumns.at(j));
-            listRow.append(index.isValid() ? m_pModel->data(index).toString() : QString());
-        }
-
-        listRows.append(listRow);
-    }
-
-    QFuture<QVector<bool>> future = QtConcurrent::run(_xtvComputeHiddenRows, listRows, listActiveFilters);
+    // The worker reads the model itself, in parallel row blocks: nothing is copied on the GUI thread
+    m_pendingOperation = OPERATION_FILTER;
+    m_listPendingFilters = listFilters;
 
-    QFutureWatcher<QVector<bool>> *pWatcher = new QFutureWatcher<QVector<bool>>(this);
+    XSortFilterProxyModel *pProxy = m_pSortFilterProxyModel;
+    m_pAsyncCancelFlag = QSharedPointer<QAtomicInt>::create(0);
+    QSharedPointer<QAtomicInt> pCancelFlag = m_pAsyncCancelFlag;
+    m_pAsyncCustomFilter = QSharedPointer<CUSTOM_FILTER_RESULT>::create();
 
-    XTableViewCustomFilterFinished functorFinished;
-    functorFinished.pView = this;
-    functorFinished.pWatcher = pWatcher;
-    functorFinished.nGeneration = nGeneration;
-    functorFinished.listFilters = listFilters;
+    QFuture<bool> future = QtConcurrent::run(_computeCustomFilter, pProxy, listFilters, pCancelFlag, m_pAsyncCustomFilter);
 
-    connect(pWatcher, &QFutureWatcher<QVector<bool>>::finished, this, functorFinished);
+    m_pAsyncWatcher = new QFutureWatcher<bool>(this);
+    connect(m_pAsyncWatcher, SIGNAL(finished()), this, SLOT(onAsyncOperationFinished()));
+    m_pAsyncWatcher->setFuture(future);
+    m_pFilterProgressTimer->start();
+    _updateModelBusy();
 
-    pWatcher->setFuture(future);
+    emit busyChanged(true);
 }
 
-static bool _xtvBuildFilterAcceptCache(XSortFilterProxyModel *pProxy, const QList<QString> &listFilters, const QSharedPointer<QAtomicInt> &pCancelFlag)
+static bool _xtvBuildFilterAcceptCache(XSortFilterProxyModel *pProxy, const QList<QString> &listFilters, const QSharedPointer<QAtomicInt> &pCancelFlag,
+                                       const QSharedPointer<XSortFilterProxyModel::PROGRESSIVE_FILTER> &pProgressive)
 {
-    return pProxy->buildFilterAcceptCache(listFilters, pCancelFlag.data());
+    return pProxy->buildFilterAcceptCache(listFilters, pCancelFlag.data(), pProgressive.data());
 }
 
 void XTableView::startAsyncFilterOperation(const QList<QString> &listFilters)
 {
+    _detachProgressiveFilter();
     cancelAsyncOperation(false);
 
     m_pendingOperation = OPERATION_FILTER;
@@ -575,42 +759,67 @@ void XTableView::startAsyncFilterOperation(const QList<QString> &listFilters)
     m_pAsyncCancelFlag = QSharedPointer<QAtomicInt>::create(0);
     QSharedPointer<QAtomicInt> pCancelFlag = m_pAsyncCancelFlag;
 
-    QFuture<bool> future = QtConcurrent::run(_xtvBuildFilterAcceptCache, pProxy, listFilters, pCancelFlag);
+    if (m_bProgressiveEnabled) {
+        // The view is emptied now and refilled by onProgressiveTimer() while the worker scans
+        m_nCustomFilterGeneration++;
+        m_nProgressiveGeneration = m_nCustomFilterGeneration;
+        m_pAsyncProgressive = pProxy->beginProgressiveFilter(listFilters);
+        m_pProgressiveTimer->start();
+    }
+
+    QSharedPointer<XSortFilterProxyModel::PROGRESSIVE_FILTER> pProgressive = m_pAsyncProgressive;
+
+    QFuture<bool> future = QtConcurrent::run(_xtvBuildFilterAcceptCache, pProxy, listFilters, pCancelFlag, pProgressive);
 
     m_pAsyncWatcher = new QFutureWatcher<bool>(this);
     connect(m_pAsyncWatcher, SIGNAL(finished()), this, SLOT(onAsyncOperationFinished()));
     m_pAsyncWatcher->setFuture(future);
+    m_pFilterProgressTimer->start();
+    _updateModelBusy();
 
     emit busyChanged(true);
 }
 
-static bool _xtvBuildSortCache(XSortFilterProxyModel *pProxy, qint32 nColumn, const QSharedPointer<QAtomicInt> &pCancelFlag)
+static bool _xtvBuildSortCache(XSortFilterProxyModel *pProxy, const QList<XModel::SORT_COLUMN> &listColumns, const QSharedPointer<QAtomicInt> &pCancelFlag)
+{
+    return pProxy->buildSortCache(listColumns, pCancelFlag.data());
+}
+
+static bool _xtvComputeRowOrder(XModel *pXModel, const QList<XModel::SORT_COLUMN> &listColumns, const QSharedPointer<QAtomicInt> &pCancelFlag,
+                                const QSharedPointer<QVector<qint32>> &pRowOrder)
 {
-    return pProxy->buildSortCache(nColumn, pCancelFlag.data());
+    return pXModel->computeRowOrder(listColumns, pRowOrder.data(), pCancelFlag.data());
 }
 
-void XTableView::startAsyncSortOperation(qint32 nColumn, Qt::SortOrder order)
+void XTableView::startAsyncSortOperation(const QList<XModel::SORT_COLUMN> &listColumns)
 {
     cancelAsyncOperation(false);
 
-    if (nColumn < 0) {
-        m_pSortFilterProxyModel->sort(nColumn, order);
+    if (listColumns.at(0).nColumn < 0) {
+        m_pSortFilterProxyModel->sort(listColumns.at(0).nColumn, listColumns.at(0).order);
         return;
     }
 
     m_pendingOperation = OPERATION_SORT;
-    m_nPendingSortColumn = nColumn;
-    m_pendingSortOrder = order;
+    m_listPendingSortColumns = listColumns;
 
     XSortFilterProxyModel *pProxy = m_pSortFilterProxyModel;
     m_pAsyncCancelFlag = QSharedPointer<QAtomicInt>::create(0);
     QSharedPointer<QAtomicInt> pCancelFlag = m_pAsyncCancelFlag;
 
-    QFuture<bool> future = QtConcurrent::run(_xtvBuildSortCache, pProxy, nColumn, pCancelFlag);
+    QFuture<bool> future;
+
+    if (m_bIsCustomSort) {
+        m_pAsyncRowOrder = QSharedPointer<QVector<qint32>>::create();
+        future = QtConcurrent::run(_xtvComputeRowOrder, m_pXModel, listColumns, pCancelFlag, m_pAsyncRowOrder);
+    } else {
+        future = QtConcurrent::run(_xtvBuildSortCache, pProxy, listColumns, pCancelFlag);
+    }
 
     m_pAsyncWatcher = new QFutureWatcher<bool>(this);
     connect(m_pAsyncWatcher, SIGNAL(finished()), this, SLOT(onAsyncOperationFinished()));
     m_pAsyncWatcher->setFuture(future);
+    _updateModelBusy();
 
     emit busyChanged(true);
 }
@@ -635,20 +844,82 @@ void XTableView::cancelAsyncOperation(bool bWait)
             m_pAsyncWatcher->waitForFinished();
             m_pAsyncWatcher->deleteLater();
         } else {
+            // Remember it: the worker may still be reading the model until it notices the flag
+            for (qint32 i = m_listCanceledFutures.count() - 1; i >= 0; i--) {
+                if (m_listCanceledFutures.at(i).isFinished()) {
+                    m_listCanceledFutures.removeAt(i);
+                }
+            }
+
+            m_listCanceledFutures.append(m_pAsyncWatcher->future());
             connect(m_pAsyncWatcher, SIGNAL(finished()), m_pAsyncWatcher, SLOT(deleteLater()));
+            connect(m_pAsyncWatcher, SIGNAL(finished()), this, SLOT(onCanceledOperationFinished()));
         }
 
         m_pAsyncWatcher = nullptr;
     }
 
+    if (bWait) {
+        // The model may be deleted next: no canceled worker is allowed to touch it anymore
+        for (qint32 i = 0; i < m_listCanceledFutures.count(); i++) {
+            m_listCanceledFutures[i].waitForFinished();
+        }
+
+        m_listCanceledFutures.clear();
+    }
+
     m_pAsyncCancelFlag.clear();
+    m_pAsyncRowOrder.clear();
+    m_pAsyncCustomFilter.clear();
+    m_pFilterProgressTimer->stop();
+
+    if (m_pAsyncProgressive) {
+        m_pProgressiveTimer->stop();
+        m_pAsyncProgressive.clear();
+
+        if (!bWait) {
+            // Stop publishing at once and bring back the filter that was shown before.
+            // Waiting callers (clear(), setCustomModel(), ~XTableView()) detach the source
+            // model right after, so restoring its old filter there would be wasted work.
+            m_pSortFilterProxyModel->abortProgressiveFilter();
+        }
+    }
     m_pendingOperation = OPERATION_NONE;
 
+    _updateModelBusy();
+
     if (bWasBusy) {
         emit busyChanged(false);
     }
 }
 
+void XTableView::_detachProgressiveFilter()
+{
+    // Another filter pass follows: the rows published so far stay until it empties the view,
+    // restoring the earlier result in between would only make the view flicker
+    m_pProgressiveTimer->stop();
+    m_pAsyncProgressive.clear();
+}
+
+void XTableView::_updateModelBusy()
+{
+    // Worker threads may read the model while an operation runs or a canceled one winds down
+    if (m_pXModel) {
+        bool bBusy = (m_pAsyncWatcher != nullptr);
+
+        for (qint32 i = 0; (i < m_listCanceledFutures.count()) && !bBusy; i++) {
+            bBusy = !m_listCanceledFutures.at(i).isFinished();
+        }
+
+        m_pXModel->setBusy(bBusy);
+    }
+}
+
+void XTableView::onCanceledOperationFinished()
+{
+    _updateModelBusy();
+}
+
 void XTableView::onAsyncOperationFinished()
 {
     QFutureWatcher<bool> *pWatcher = m_pAsyncWatcher;
@@ -660,18 +931,49 @@ void XTableView::onAsyncOperationFinished()
 
     pWatcher->deleteLater();
     m_pAsyncCancelFlag.clear();
+    m_pFilterProgressTimer->stop();
+    _updateModelBusy();
+
+    QSharedPointer<CUSTOM_FILTER_RESULT> pCustomFilter = m_pAsyncCustomFilter;
+    m_pAsyncCustomFilter.clear();
+
+    bool bProgressive = !m_pAsyncProgressive.isNull();
+    m_pAsyncProgressive.clear();
+    m_pProgressiveTimer->stop();
 
-    if (bSuccess) {
-        if (op == OPERATION_FILTER) {
+    if (bSuccess && (op == OPERATION_FILTER) && !pCustomFilter) {
+        m_nFilterPassRows = m_pSortFilterProxyModel->getFilterEvaluatedRows();
+        _endFilterPass();
+    }
+
+    if (bProgressive) {
+        if (bSuccess) {
+            m_pSortFilterProxyModel->endProgressiveFilter();
+        } else {
+            m_pSortFilterProxyModel->abortProgressiveFilter();
+        }
+    } else if (bSuccess) {
+        if ((op == OPERATION_FILTER) && pCustomFilter) {
+            m_nFilterPassRows = pCustomFilter->nEvaluated;
+            applyCustomFilterResult(m_listPendingFilters, pCustomFilter->vecAccepted);
+        } else if (op == OPERATION_FILTER) {
             m_pSortFilterProxyModel->setFiltersQuiet(m_listPendingFilters);
             m_pSortFilterProxyModel->invalidate();
         } else if (op == OPERATION_SORT) {
             QSignalBlocker blocker(m_pHeaderView);
             m_bApplyingAsyncSort = true;
-            m_pSortFilterProxyModel->sort(m_nPendingSortColumn, m_pendingSortOrder);
+
+            if (m_pAsyncRowOrder) {
+                m_pXModel->applyRowOrder(*m_pAsyncRowOrder);
+            } else {
+                m_pSortFilterProxyModel->sortByColumns(m_listPendingSortColumns);
+            }
+
             m_bApplyingAsyncSort = false;
         }
     }
 
+    m_pAsyncRowOrder.clear();
+
     emit busyChanged(false);
 }
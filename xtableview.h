@@ -26,6 +26,7 @@
 #include <QScrollBar>
 #include <QStandardItemModel>
 #include <QElapsedTimer>
+#include <QFuture>
 #include <QFutureWatcher>
 #include <QAtomicInt>
 #include <QItemSelectionModel>
@@ -60,34 +61,60 @@ public:
     void setThreadedFilterSortEnabled(bool bEnabled);
     bool isThreadedFilterSortEnabled() const;
 
+    // Opt-in, threaded filtering only: instead of waiting for the whole pass, the accepted
+    // rows are appended to the view in batches while the worker is still scanning.
+    void setProgressiveFilterEnabled(bool bEnabled);
+    bool isProgressiveFilterEnabled() const;
+
 public slots:
     void setSortingEnabled(bool bEnable);
     void sortByColumn(int column, Qt::SortOrder order);
+    void sortByColumns(const QList<XModel::SORT_COLUMN> &listColumns);  // Primary key first
 
 signals:
     void invalidateSignal();
     void busyChanged(bool bBusy);
+    void filterProgress(qint32 nValue, qint32 nMaximum);  // Threaded filter pass: rows scanned so far
 
 private:
-    friend struct XTableViewCustomFilterFinished;
-
     void deleteOldModel(QAbstractItemModel **ppOldModel);
     void replaceModel(QAbstractItemModel *pModel);
     void handleFilter();
 
     enum PENDING_OPERATION { OPERATION_NONE = 0, OPERATION_FILTER, OPERATION_SORT };
 
+    struct CUSTOM_FILTER_RESULT {
+        QVector<bool> vecAccepted;
+        qint32 nEvaluated;
+    };
+
+    static bool _computeCustomFilter(XSortFilterProxyModel *pProxy, const QList<QString> &listFilters, const QSharedPointer<QAtomicInt> &pCancelFlag,
+                                     const QSharedPointer<CUSTOM_FILTER_RESULT> &pResult);
+
     void startAsyncFilterOperation(const QList<QString> &listFilters);
     void startAsyncCustomFilterOperation(const QList<QString> &listFilters);
-    void startAsyncSortOperation(qint32 nColumn, Qt::SortOrder order);
+    void applyCustomFilterResult(const QList<QString> &listFilters, const QVector<bool> &vecAccepted);
+    void startAsyncSortOperation(const QList<XModel::SORT_COLUMN> &listColumns);
     void cancelAsyncOperation(bool bWait = true);
+    void _updateModelBusy();
+    void _detachProgressiveFilter();
+    qint64 _getPredictedFilterCost() const;  // ms for a pass over the current model
+    void _beginFilterPass();
+    void _endFilterPass();  // Measures the throughput of the pass started by onFilterApply()
+
+protected:
+    void showEvent(QShowEvent *pEvent) override;
 
 private slots:
     void onFilterChanged();
     void onFilterApply();
     void onSortChanged(int column, Qt::SortOrder order);
+    void onMultiSortChanged(const QList<XModel::SORT_COLUMN> &listColumns);
     void horizontalScroll();
     void onAsyncOperationFinished();
+    void onCanceledOperationFinished();
+    void onProgressiveTimer();
+    void onFilterProgressTimer();
     void onSourceModelReset();
 
 private:
@@ -110,11 +137,21 @@ private:
     bool m_bApplyingAsyncSort;
     QFutureWatcher<bool> *m_pAsyncWatcher;
     QSharedPointer<QAtomicInt> m_pAsyncCancelFlag;
+    QList<QFuture<bool>> m_listCanceledFutures;     // Canceled without waiting; may still read the model
+    bool m_bProgressiveEnabled;
+    QTimer *m_pProgressiveTimer;
+    QSharedPointer<XSortFilterProxyModel::PROGRESSIVE_FILTER> m_pAsyncProgressive;
+    qint32 m_nProgressiveGeneration;
     PENDING_OPERATION m_pendingOperation;
     QList<QString> m_listPendingFilters;
-    qint32 m_nPendingSortColumn;
-    Qt::SortOrder m_pendingSortOrder;
+    QList<XModel::SORT_COLUMN> m_listPendingSortColumns;
+    QSharedPointer<QVector<qint32>> m_pAsyncRowOrder;  // Custom sort: the order computed by the worker
+    QSharedPointer<CUSTOM_FILTER_RESULT> m_pAsyncCustomFilter;  // Custom filter: the rows accepted by the worker
+    QTimer *m_pFilterProgressTimer;
     qint32 m_nCustomFilterGeneration;
+    double m_dFilterRowsPerMs;  // Filter throughput measured on the current model, 0: not measured yet
+    QElapsedTimer m_filterPassTimer;
+    qint32 m_nFilterPassRows;  // Rows the pass actually evaluated
 };
 
 #endif  // XTABLEVIEW_H
@@ -1,6 +1,8 @@
 INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 
+QT += concurrent
+
 !contains(XCONFIG, xmodel) {
     XCONFIG += xmodel
     include($$PWD/xmodel.pri)